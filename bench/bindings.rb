@@ -0,0 +1,161 @@
+# What every binding in the main Native modules costs per call
+#
+# Run with `rake bench:bindings[out.json]`. Each binding is called with
+# stand-in arguments under the headless frontend, drawing into its fbo.
+# Bindings that can't be called safely over and over, or that take an
+# object or raw pointer there is no real stand-in for, are listed under
+# "skipped" with the reason.
+require_relative "harness"
+
+module Bench
+  module Bindings
+    Modules = {
+      "Graphics::Native"         => Zajal::Graphics::Native,
+      "App::Native"              => Zajal::App::Native,
+      "Images::Image::Native"    => Zajal::Images::Image::Native,
+      "Typography::Native"       => Zajal::Typography::Native,
+      "Graphics::Shader::Native" => Zajal::Graphics::Shader::Native,
+      "Graphics::Fbo::Native"    => Zajal::Graphics::Fbo::Native,
+      "Time::Native"             => Zajal::Time::Native,
+    }
+
+    Samples = (ENV["SAMPLES"] || 20).to_i
+    Calls = (ENV["CALLS"] || 1000).to_i
+
+    Skip = {
+      ofSetupOpenGL: "opens a window",
+      ofBeginSaveScreenAsPDF: "writes a file",
+      ofEndSaveScreenAsPDF: "writes a file",
+      ofSleepMillis: "sleeps",
+      ofSetFullscreen: "changes the window",
+      ofToggleFullscreen: "changes the window",
+      ofSetDataPathRoot: "changes where files load from",
+      ofimage_loadImage: "reads a file",
+      ofimage_saveImage: "writes a file",
+      oftruetypefont_loadFont: "reads a file",
+      ofshader_load: "reads files",
+      ofshader_setupShaderFromFile: "reads a file",
+      ofshader_setupShaderFromSource: "compiles a shader",
+      ofshader_linkProgram: "links a program",
+      ofshader_printActiveUniforms: "prints",
+      ofshader_printActiveAttributes: "prints",
+    }
+
+    # Bindings that have to be undone before they can be called again are
+    # timed together with their undoing
+    Pairs = {
+      ofPushMatrix: :ofPopMatrix,
+      ofPushStyle: :ofPopStyle,
+      ofPushView: :ofPopView,
+      ofBeginShape: :ofEndShape,
+      offbo_begin: :offbo_end,
+      ofshader_begin: :ofshader_end,
+    }
+
+    # Arguments after the instance, where ones made up from the types won't do
+    Arguments = {
+      ofimage_crop: [0, 0, 1, 1],
+      ofimage_resize: [16, 16],
+      ofimage_grabScreen: [0, 0, 16, 16],
+      oftruetypefont_drawString: ["zajal".freeze.to_ptr, 10.0, 10.0],
+      ofLinePoints: [Zajal::Vec3.new(0, 0, 0).to_ptr, Zajal::Vec3.new(1, 1, 0).to_ptr],
+      ofTrianglePoints: [Zajal::Vec3.new(0, 0, 0).to_ptr, Zajal::Vec3.new(1, 0, 0).to_ptr, Zajal::Vec3.new(0, 1, 0).to_ptr],
+    }
+
+    # Uniform arrays get one element's worth of components each
+    (1..4).each do |n|
+      ints = FFI::MemoryPointer.new(:int, n).put_array_of_int(0, [1] * n)
+      floats = FFI::MemoryPointer.new(:float, n).put_array_of_float(0, [1.0] * n)
+      Arguments[:"ofshader_setUniform#{n}iv"] = ["zajal", ints, 1]
+      Arguments[:"ofshader_setUniform#{n}fv"] = ["zajal", floats, 1]
+    end
+
+    # Instances methods are called on, set up enough to be used
+    Setup = {
+      ofFbo: lambda { |fbo| Zajal::Graphics::Fbo::Native.offbo_allocate fbo, 64, 64, 0x1908, 0 },
+      ofImage: lambda { |image| Zajal::Images::Image::Native.ofimage_grabScreen image, 0, 0, 16, 16 },
+      ofTrueTypeFont: lambda { |font| Zajal::Typography::Native.oftruetypefont_loadFont font, File.expand_path("../lib/zajal/core/bin/gohu.ttf", File.dirname(__FILE__)).to_ptr, 8, false, false, false, 0.0, 0 },
+    }
+
+    Values = {
+      float: 1.0, double: 1.0, int: 1, uint: 1, short: 1, ushort: 1, long: 1, ulong: 1,
+      char: 1, uchar: 1, bool: false, string: "zajal",
+    }
+
+    def self.value mod, type
+      case type
+      when :stdstring then "zajal".freeze.to_ptr
+      when :ofVec3f, :ofPoint then Zajal::Vec3.new(1, 1, 0).to_ptr
+      when :ofMatrix4x4 then Zajal::Mat4.new.to_ptr
+      when :pointer then raise ArgumentError, "takes a raw pointer with nothing real to point it at"
+      else
+        return Values[type] if Values.key? type
+        enum = mod.enum_type type if mod.respond_to? :enum_type
+        raise ArgumentError, "no stand-in for #{type}" unless enum
+        enum.symbols.first
+      end
+    end
+
+    def self.instance mod, klass
+      @instances ||= {}
+      raise ArgumentError, "no constructor for #{klass}" unless mod.respond_to? "#{klass.downcase}_new"
+      @instances[klass] ||= mod.send("#{klass.downcase}_new").tap do |instance|
+        Setup[klass].call instance if Setup[klass]
+      end
+    end
+
+    # @return [Proc] calls the binding once, with its pair if it has one
+    def self.call mod, declaration
+      name = declaration.name
+      raise ArgumentError, Skip[name] if Skip[name]
+      raise ArgumentError, "timed with #{Pairs.key(name)}" if Pairs.value? name
+
+      if name.to_s.end_with? "_ctor"
+        dtor = name.to_s.sub(/_ctor$/, "_dtor")
+        raise ArgumentError, "leaks without a destructor" unless mod.respond_to? dtor
+        raise ArgumentError, "takes arguments" unless declaration.params.size == 1
+        memory = mod.send name.to_s.sub(/_ctor$/, "_alloc")
+        return lambda { mod.send name, memory; mod.send dtor, memory }
+      end
+
+      raise ArgumentError, "timed with #{name.to_s.sub(/_dtor$/, '_ctor')}" if name.to_s.end_with? "_dtor"
+
+      params = declaration.klass ? declaration.params.drop(1) : declaration.params
+      args = Arguments[name] ? Arguments[name].dup : params.map { |type| value mod, type }
+      args.unshift instance(mod, declaration.klass) if declaration.klass
+
+      undo = Pairs[name]
+      undo_args = declaration.klass ? [args.first] : []
+      undo_args << false if undo == :ofEndShape
+      undo ? lambda { mod.send name, *args; mod.send undo, *undo_args } : lambda { mod.send name, *args }
+    end
+
+    def self.run path=nil
+      frontend = Zajal::Frontends::Headless.new 256, 256
+      baseline = Bench.baseline Samples, Calls
+      results, skipped = [], []
+
+      frontend.fbo.use do
+        Modules.each do |module_name, mod|
+          mod.declarations.each_value do |declaration|
+            begin
+              blk = call mod, declaration
+            rescue ArgumentError => e
+              skipped << { module: module_name, binding: declaration.name, reason: e.message }
+              next
+            end
+
+            stats = Bench.measure Samples, Calls, &blk
+            results << { module: module_name, binding: declaration.name, paired_with: Pairs[declaration.name] }.
+              merge(ns_per_call: stats[:mean] - baseline).merge(stats)
+          end
+        end
+      end
+
+      frontend.close
+      Bench.report({ samples: Samples, calls: Calls, baseline_ns: baseline, bindings: results, skipped: skipped }, path)
+    end
+  end
+end
+
+Bench::Bindings.run ARGV.first if $0 == __FILE__
@@ -0,0 +1,108 @@
+# Frame times of the stress sketches in bench/sketches
+#
+# Run with `rake bench:frames[frames,out.json]`. Each sketch renders under
+# the headless frontend twice: once timing every frame and counting the
+# Ruby objects it allocates, then again for a few frames with every FFIPP
+# binding counting its calls. Counting slows calls down, so the two passes
+# are kept apart. Set SKETCHES to a comma separated list of names to run
+# only some of them.
+require_relative "harness"
+
+module Bench
+  module Frames
+    Sketches = File.expand_path("sketches", File.dirname(__FILE__))
+
+    # frames left out of the timings, while caches and bindings warm up
+    Warmup = (ENV["WARMUP"] || 10).to_i
+
+    # frames the counting pass renders
+    Counted = (ENV["COUNTED"] || 5).to_i
+
+    Width, Height = 400, 400
+
+    # Counts calls to every binding attached with FFIPP
+    module Calls
+      class << self
+        attr_accessor :count
+      end
+      @count = 0
+
+      def self.install
+        return if @installed
+
+        ObjectSpace.each_object(Module).select { |mod| FFI::Cpp::Library === mod }.each do |mod|
+          names = mod.declarations.keys
+          next if names.empty?
+
+          mod.singleton_class.send :prepend, Module.new {
+            names.each do |name|
+              define_method(name) { |*args, &blk| Calls.count += 1; super(*args, &blk) }
+            end
+          }
+        end
+        @installed = true
+      end
+    end
+
+    def self.sketch frontend, path
+      frontend.sketch = Zajal::Frontends::Headless::Sketch.new open(path)
+    end
+
+    # @return [Hash] frame times and allocations per frame
+    def self.time frontend, path, frames
+      times, allocations = [], []
+
+      sketch frontend, path
+      last, allocated = Bench.now, Bench.allocations
+      frontend.run Warmup + frames do |frame|
+        now, objects = Bench.now, Bench.allocations
+        if frame >= Warmup
+          times << (now - last) / 1e6
+          allocations << objects - allocated if objects
+        end
+        last, allocated = Bench.now, Bench.allocations
+      end
+
+      {
+        frames: frames,
+        frame_ms: distribution(times),
+        allocations_per_frame: allocations.empty? ? nil : distribution(allocations),
+      }
+    end
+
+    # @return [Float] binding calls per frame
+    def self.count frontend, path
+      sketch frontend, path
+      Calls.install
+      Calls.count = 0
+      frontend.run Counted
+      Calls.count.to_f / Counted
+    end
+
+    # @return [Hash] mean and percentiles of +values+
+    def self.distribution values
+      sorted = values.sort
+      at = lambda { |p| sorted[[(p * sorted.size).ceil - 1, 0].max] }
+
+      { mean: values.inject(0.0, :+) / values.size, p50: at[0.5], p95: at[0.95], p99: at[0.99], max: sorted.last }
+    end
+
+    # @return [Array<String>] names of the sketches to run
+    def self.names
+      ENV["SKETCHES"] ? ENV["SKETCHES"].split(",") : Dir["#{Sketches}/*.zj"].map { |f| File.basename f, ".zj" }.sort
+    end
+
+    def self.run frames=300, path=nil
+      frontend = Zajal::Frontends::Headless.new Width, Height
+
+      # counting can't be taken out again, so every sketch is timed first
+      results = Hash[names.map { |name| [name, time(frontend, "#{Sketches}/#{name}.zj", frames.to_i)] }]
+      names.each { |name| results[name][:ffi_calls_per_frame] = count(frontend, "#{Sketches}/#{name}.zj") }
+
+      frontend.close
+      Bench.report({ width: Width, height: Height, warmup: Warmup, sketches: results }, path)
+    end
+  end
+end
+
+Bench::Frames.run *ARGV if $0 == __FILE__
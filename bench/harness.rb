@@ -0,0 +1,74 @@
+# Timing and reporting shared by the benchmarks in bench/
+require "json"
+$:.unshift File.expand_path("../lib", File.dirname(__FILE__))
+require "zajal"
+
+module Bench
+  # @return [Integer] nanoseconds from a monotonic clock where there is one
+  def self.now
+    Process.clock_gettime Process::CLOCK_MONOTONIC, :nanosecond
+  rescue NameError, ArgumentError
+    (::Time.now.to_f * 1e9).to_i
+  end
+
+  # @return [Integer, nil] objects allocated so far, nil if this Ruby
+  #   doesn't count them
+  def self.allocations
+    return nil unless GC.respond_to? :stat
+    stat = GC.stat
+    stat[:total_allocated_objects] || stat[:total_allocated_object]
+  end
+
+  # Time a block
+  #
+  # Runs it +calls+ times to warm up, then +samples+ batches of +calls+
+  # times, and once more counting allocations. The cost of the loop itself
+  # is measured the same way and taken off.
+  #
+  # @return [Hash] nanoseconds per call (mean, median, min, variance and
+  #   standard deviation across samples) and allocations per call
+  def self.measure samples, calls
+    calls.times { yield }
+    times = Array.new(samples) do
+      start = now
+      calls.times { yield }
+      (now - start).to_f / calls
+    end
+
+    before = allocations
+    calls.times { yield }
+    after = allocations
+
+    stats(times).merge(allocations_per_call: before && after && (after - before).to_f / calls)
+  end
+
+  # @return [Float] nanoseconds per call of an empty block, taken off
+  #   every measurement
+  def self.baseline samples, calls
+    @baseline ||= measure(samples, calls) { }[:mean]
+  end
+
+  def self.stats values
+    sorted = values.sort
+    mean = values.inject(0.0, :+) / values.size
+    variance = values.inject(0.0) { |sum, v| sum + (v - mean) ** 2 } / values.size
+
+    { mean: mean, median: sorted[sorted.size / 2], min: sorted.first, variance: variance, stddev: Math.sqrt(variance) }
+  end
+
+  # Details of the machine, to tell results apart
+  def self.environment
+    {
+      ruby: RUBY_DESCRIPTION,
+      platform: RUBY_PLATFORM,
+      zajal: Zajal::VERSION,
+      time: ::Time.now.utc.strftime("%Y-%m-%dT%H:%M:%SZ"),
+    }
+  end
+
+  # Write a report as JSON to +path+, or stdout without one
+  def self.report results, path=nil
+    json = JSON.pretty_generate environment.merge(results)
+    path ? File.open(path, "w") { |f| f.puts json } : puts(json)
+  end
+end
@@ -0,0 +1,254 @@
+// The stress sketches in bench/sketches, drawn straight against
+// openFrameworks
+//
+// Each scene draws what its sketch draws, the same way underneath (e.g.
+// points go through libzajal's drawVertices like a Buffer does), so the
+// difference in frame time between the two is what the Ruby and FFIPP
+// layer costs. Frames are set up the way the headless frontend sets them
+// up. Prints frame time distributions as JSON in the shape bench/frames.rb
+// uses.
+//
+// Usage: scenes frames warmup path/to/gohu.ttf
+
+#include "ofMain.h"
+#include "MinimalFrontend.h"
+#include "PostChain.h"
+#include "Random.h"
+#include "Vertices.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+static const int width = 400, height = 400;
+
+/* scenes */
+
+class Scene {
+public:
+  virtual ~Scene() {}
+  virtual const char* name() = 0;
+  virtual void setup() {}
+  virtual void draw(int frame) = 0;
+};
+
+class Circles : public Scene {
+public:
+  const char* name() { return "circles"; }
+
+  void draw(int frame) {
+    for(int i = 0; i < 10000; i++)
+      ofCircle(200 + sin(i)*(30 + i * 0.02f), 150 + cos(i)*(30 + i * 0.02f), 1 + i * 0.001f);
+  }
+};
+
+class Points : public Scene {
+public:
+  const char* name() { return "points"; }
+
+  void setup() {
+    points.resize(50000 * 2);
+    random.seed(0, 0, RANDOM_XOSHIRO);
+  }
+
+  void draw(int frame) {
+    random.fillUniform(&points[0], 50000, 2, 0, width);
+    random.fillUniform(&points[1], 50000, 2, 0, height);
+    drawVertices(&points[0], 50000, 2, GL_POINTS);
+  }
+
+  vector<float> points;
+  RandomStream random;
+};
+
+class Text : public Scene {
+public:
+  Text(const char* fontPath) : fontPath(fontPath) {}
+
+  const char* name() { return "text"; }
+
+  void setup() {
+    font.loadFont(fontPath, 8, false);
+  }
+
+  void draw(int frame) {
+    char line[128];
+    for(int i = 0; i < 40; i++) {
+      snprintf(line, sizeof(line), "line %d: frame %d at %.3fs, noise %.4f", i, frame, ofGetElapsedTimef(), ofNoise(i * 0.1f));
+      font.drawString(line, 1, 10 + i * 10);
+    }
+  }
+
+  const char* fontPath;
+  ofTrueTypeFont font;
+};
+
+class Images : public Scene {
+public:
+  const char* name() { return "images"; }
+
+  void setup() {
+    ofCircle(16, 16, 12);
+    tile.grabScreen(0, 0, 32, 32);
+  }
+
+  void draw(int frame) {
+    for(int i = 0; i < 1000; i++)
+      tile.draw((i * 37) % width, (i * 53) % height);
+  }
+
+  ofImage tile;
+};
+
+class Shaders : public Scene {
+public:
+  const char* name() { return "shaders"; }
+
+  void setup() {
+    string vertex =
+      "void main() {\n"
+      "  gl_TexCoord[0] = gl_MultiTexCoord0;\n"
+      "  gl_Position = ftransform();\n"
+      "}\n";
+
+    blur.setupShaderFromSource(GL_VERTEX_SHADER, vertex);
+    blur.setupShaderFromSource(GL_FRAGMENT_SHADER,
+      "uniform sampler2DRect source;\n"
+      "uniform vec2 direction;\n"
+      "void main() {\n"
+      "  vec2 uv = gl_TexCoord[0].st;\n"
+      "  gl_FragColor = (texture2DRect(source, uv - direction) + texture2DRect(source, uv) + texture2DRect(source, uv + direction)) / 3.0;\n"
+      "}\n");
+    blur.linkProgram();
+
+    tint.setupShaderFromSource(GL_VERTEX_SHADER, vertex);
+    tint.setupShaderFromSource(GL_FRAGMENT_SHADER,
+      "uniform sampler2DRect source;\n"
+      "uniform float amount;\n"
+      "void main() {\n"
+      "  gl_FragColor = texture2DRect(source, gl_TexCoord[0].st) * vec4(1.0, amount, amount, 1.0);\n"
+      "}\n");
+    tint.linkProgram();
+
+    // the scene, then three buffers to ping-pong, like Zajal's PostChain
+    chain.setup(width, height, 4);
+  }
+
+  void draw(int frame) {
+    float time = ofGetElapsedTimef();
+
+    chain.begin(0);
+    for(int i = 0; i < 100; i++)
+      ofCircle(width / 2 + sin(time + i) * 100, height / 2 + cos(time + i) * 100, 10);
+    chain.end(0);
+
+    pass(0, 0, 1, blur, "direction", 2, 1, 0);
+    pass(1, 1, 2, blur, "direction", 2, 0, 1);
+    pass(2, 2, 1, tint, "amount", 1, 0.5f + sin(time) * 0.5f, 0);
+    pass(3, 1, 2, blur, "direction", 2, 2, 2);
+    chain.draw(2, 0, 0);
+  }
+
+  // one uniform of 1 or 2 components
+  void pass(int i, int input, int target, ofShader& shader, const char* uniform, int components, float x, float y) {
+    chain.beginPass(i, target);
+    shader.begin();
+    if(components == 1)
+      shader.setUniform1f(uniform, x);
+    else
+      shader.setUniform2f(uniform, x, y);
+    chain.drawBuffer(input);
+    shader.end();
+    chain.endPass(i, target);
+  }
+
+  ofShader blur, tint;
+  PostChain chain;
+};
+
+class Shapes : public Scene {
+public:
+  const char* name() { return "shapes"; }
+
+  void draw(int frame) {
+    float time = ofGetElapsedTimef();
+
+    ofBeginShape();
+    for(int i = 0; i < 5000; i++)
+      ofVertex(width / 2 + sin(i * 0.01f + time) * i * 0.04f, height / 2 + cos(i * 0.0107f) * i * 0.04f);
+    ofEndShape(true);
+  }
+};
+
+/* timing */
+
+// nearest rank, like Bench::Frames.distribution
+static double percentile(vector<double>& sorted, double p) {
+  int rank = (int)ceil(p * sorted.size()) - 1;
+  return sorted[std::max(rank, 0)];
+}
+
+static void run(Scene& scene, MinimalFrontend& frontend, ofFbo& fbo, int frames, int warmup, bool last) {
+  vector<double> times;
+
+  for(int frame = 0; frame < warmup + frames; frame++) {
+    unsigned long long start = ofGetElapsedTimeMicros();
+
+    frontend.beginFrame();
+    fbo.begin();
+    ofSetupScreen();
+    ofClear(0, 0, 0, 255);
+    ofSetupScreenPerspective(width, height, OF_ORIENTATION_DEFAULT, false, 60, 0, 0);
+    if(frame == 0)
+      scene.setup();
+    scene.draw(frame);
+    fbo.end();
+
+    if(frame >= warmup)
+      times.push_back((ofGetElapsedTimeMicros() - start) / 1000.0);
+  }
+
+  double mean = 0;
+  for(size_t i = 0; i < times.size(); i++)
+    mean += times[i];
+  mean /= times.size();
+  std::sort(times.begin(), times.end());
+
+  printf("    \"%s\": {\n", scene.name());
+  printf("      \"frames\": %d,\n", frames);
+  printf("      \"frame_ms\": { \"mean\": %f, \"p50\": %f, \"p95\": %f, \"p99\": %f, \"max\": %f }\n",
+    mean, percentile(times, 0.5), percentile(times, 0.95), percentile(times, 0.99), times.back());
+  printf("    }%s\n", last ? "" : ",");
+}
+
+int main(int argc, char** argv) {
+  if(argc < 4) {
+    fprintf(stderr, "usage: %s frames warmup path/to/gohu.ttf\n", argv[0]);
+    return 1;
+  }
+
+  int frames = std::max(atoi(argv[1]), 1);
+  int warmup = std::max(atoi(argv[2]), 0);
+
+  MinimalFrontend frontend;
+  ofSetupOpenGL(&frontend, width, height, OF_WINDOW);
+
+  ofFbo fbo;
+  fbo.allocate(width, height, GL_RGBA);
+
+  Circles circles;
+  Images images;
+  Points points;
+  Shaders shaders;
+  Shapes shapes;
+  Text text(argv[3]);
+  Scene* scenes[] = { &circles, &images, &points, &shaders, &shapes, &text };
+  int count = sizeof(scenes) / sizeof(scenes[0]);
+
+  printf("{\n  \"width\": %d,\n  \"height\": %d,\n  \"warmup\": %d,\n  \"sketches\": {\n", width, height, warmup);
+  for(int i = 0; i < count; i++)
+    run(*scenes[i], frontend, fbo, frames, warmup, i == count - 1);
+  printf("  }\n}\n");
+
+  return 0;
+}
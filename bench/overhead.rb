@@ -0,0 +1,44 @@
+# How much of each stress sketch's frame time is Zajal's own
+#
+# Run with `rake bench:overhead[frames,out.json]`, after building the
+# native reference scenes with `rake build[of_dir]` in bench/native. Each
+# sketch in bench/sketches is timed under the headless frontend, next to
+# its scene drawn straight against openFrameworks by bench/native/scenes.
+# The ratio of the two is the cost of the Ruby and FFIPP layer: a scene at
+# 1.0 is all openFrameworks, one at 10 spends nine tenths of its frame in
+# Zajal. Scenes are listed by milliseconds of overhead, most first.
+require_relative "frames"
+
+module Bench
+  module Overhead
+    Scenes = File.expand_path("native/scenes", File.dirname(__FILE__))
+    Font = File.expand_path("../lib/zajal/core/bin/gohu.ttf", File.dirname(__FILE__))
+
+    def self.run frames=300, path=nil
+      raise "no native scenes at #{Scenes}, build them with `rake build[of_dir]` in bench/native" unless File.executable? Scenes
+
+      native = JSON.parse(`"#{Scenes}" #{frames.to_i} #{Frames::Warmup} "#{Font}"`)["sketches"]
+      frontend = Zajal::Frontends::Headless.new Frames::Width, Frames::Height
+
+      scenes = Frames.names.select { |name| native[name] }.map do |name|
+        zajal = Frames.time(frontend, "#{Frames::Sketches}/#{name}.zj", frames.to_i)[:frame_ms]
+        reference = native[name]["frame_ms"]
+
+        {
+          scene: name,
+          zajal_ms: zajal,
+          native_ms: reference,
+          overhead_ms: zajal[:mean] - reference["mean"],
+          overhead_ratio: zajal[:mean] / reference["mean"],
+          zajal_share: 1.0 - reference["mean"] / zajal[:mean],
+        }
+      end
+
+      scenes.sort_by! { |scene| -scene[:overhead_ms] }
+      frontend.close
+      Bench.report({ frames: frames.to_i, warmup: Frames::Warmup, scenes: scenes }, path)
+    end
+  end
+end
+
+Bench::Overhead.run *ARGV if $0 == __FILE__
@@ -8,6 +8,7 @@ require "zajal/extensions/range"
 require "zajal/ffipp"
 require "zajal/core"
 require "zajal/version"
+require "zajal/frontends/trace"
 require "zajal/frontends/frontend"
 require "zajal/frontends/headless"
 require "zajal/frontends/glfw"
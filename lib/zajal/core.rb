@@ -1,18 +1,45 @@
-# Load openFrameworks' binary dependancies into the process
-%w[PocoFoundation PocoNet PocoXML PocoUtil glew tess freeimage freetype].each do |libname|
-  FFI::DynamicLibrary.open_library File.expand_path("core/lib/#{libname}.so", File.dirname(__FILE__)), FFI::DynamicLibrary::RTLD_LAZY | FFI::DynamicLibrary::RTLD_GLOBAL
+# Load openFrameworks' binary dependancies into the process. libof refers
+# to PocoNet's data, so it has to be there before libof loads, but nothing
+# refers to PocoXML or PocoUtil until a binding into them is attached, so
+# they're only opened then.
+%w[PocoFoundation PocoNet glew tess freeimage freetype].each do |libname|
+  FFI::Cpp.open_library File.expand_path("core/lib/#{libname}.so", File.dirname(__FILE__))
 end
 
+%w[PocoXML PocoUtil].each do |libname|
+  FFI::Cpp.defer_library File.expand_path("core/lib/#{libname}.so", File.dirname(__FILE__))
+end
+
+# Bind everything up front with ZAJAL_EAGER_BINDING set, to check symbols
+FFI::Cpp::Library.eager = ENV.key? "ZAJAL_EAGER_BINDING"
+
+# Count and time every binding call per frame with ZAJAL_PROFILE set
+FFI::Cpp::Profiler.enabled = ENV.key? "ZAJAL_PROFILE"
+
+# Modules without an ffi_lib attach to libof, already linked into the process
+FFI::Cpp::SymbolTable.default = FFI::Cpp::SymbolTable.for File.expand_path("core/lib/libof.so", File.dirname(__FILE__))
+
+require "zajal/core/cache"
+require "zajal/core/resources"
 require "zajal/core/app"
+require "zajal/core/buffer"
+require "zajal/core/vectors"
+require "zajal/core/shim"
 require "zajal/core/graphics"
 require "zajal/core/fbo"
 require "zajal/core/shader"
+require "zajal/core/post_chain"
 require "zajal/core/pixels"
 require "zajal/core/images"
+require "zajal/core/atlas"
 require "zajal/core/mathematics"
+require "zajal/core/random"
+require "zajal/core/particles"
+require "zajal/core/spatial"
 require "zajal/core/time"
 require "zajal/core/typography"
 require "zajal/core/color"
 
+require "zajal/core/file_watcher"
 require "zajal/core/sketch"
 require "zajal/core/thanks"
\ No newline at end of file
@@ -66,6 +66,17 @@ module Zajal
       Native.ofGetLastFrameTime
     end
 
+    # Count the native objects that are still alive
+    # 
+    # Useful for catching images, fbos, shaders and fonts that are made
+    # every frame or survive reloads.
+    # 
+    # @return [Hash{Symbol => Fixnum}] live objects by C++ class
+    # @api internal
+    def live_objects
+      FFI::Cpp::Owned.live
+    end
+
     # @overload cursor show
     #   Show or hide the cursor
     #   @example Hide on mouse click, show on key press
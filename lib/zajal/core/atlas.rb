@@ -0,0 +1,196 @@
+module Zajal
+  module Images
+    # Many small images packed into a few large textures
+    #
+    # Drawing an {Image} binds its texture and makes a native call every
+    # time. An {Atlas} packs all of its sources onto shared pages up front, so
+    # that a {#batch} of any number of sprites costs one texture bind and one
+    # draw call per page.
+    #
+    # Packing is cached on disk (see {Zajal::Cache}), keyed by the contents of
+    # the sources, so an unchanged atlas loads its pages instead of repacking.
+    #
+    # @example Drawing a thousand sprites
+    #   sprites = Atlas.new Dir["sprites/*.png"]
+    #
+    #   draw do
+    #     sprites.batch do |b|
+    #       1000.times { b.draw "sprites/star.png", random(width), random(height) }
+    #     end
+    #   end
+    class Atlas
+      # @return [Array<Image>] the packed pages
+      attr_reader :pages
+
+      # Pack images into an atlas
+      #
+      # @param sources [Array<#to_s,Image>] file names or {Image}s to pack.
+      #   Regions are looked up by the same object later.
+      # @param options [Hash] packing options
+      # @option options [Fixnum] :size width and height of each page
+      # @option options [Fixnum] :padding empty pixels between regions
+      # @option options [Boolean] :cache read and write the on-disk cache?
+      def initialize sources, options={}
+        options = { size:1024, padding:1, cache:true }.merge options
+
+        @pointer = Native.textureatlas_new
+        Native.textureatlas_setup @pointer, options[:size].to_i, options[:size].to_i, options[:padding].to_i
+
+        images = sources.map { |s| s.is_a?(Image) ? s : Image.new(s) }
+        keys = sources.map { |s| s.is_a?(Image) ? s : s.to_s }
+        key = Cache.key options[:size], options[:padding], *images.map { |i| digest i }
+        layout = Cache.path "atlas", key, "layout"
+
+        if options[:cache] and File.exist? layout
+          regions, page_count = Marshal.load File.binread(layout)
+          @pages = page_count.times.map { |i| Image.new Cache.path("atlas", key, "page-#{i}.png") }
+        else
+          regions, @pages = pack images
+          if options[:cache]
+            @pages.each_with_index { |page, i| page.save Cache.path("atlas", key, "page-#{i}.png") }
+            File.binwrite layout, Marshal.dump([regions, @pages.size])
+          end
+        end
+
+        @regions = Hash[keys.zip(regions)]
+      end
+
+      # The region a source was packed into
+      #
+      # @param source [#to_s,Image] a source passed to {#initialize}
+      # @return [Array] page index, x, y, width, height
+      def [] source
+        @regions[source.is_a?(Image) ? source : source.to_s] or raise ArgumentError, "#{source.inspect} is not in this atlas"
+      end
+
+      # Draw a single region
+      #
+      # Prefer {#batch} when drawing more than a handful of regions.
+      #
+      # @see Batch#draw
+      def draw source, x, y, w=nil, h=nil
+        batch { |b| b.draw source, x, y, w, h }
+      end
+
+      # Draw many regions at once
+      #
+      # Regions drawn inside the block are collected and drawn when the block
+      # returns, with a single draw call per page.
+      #
+      # @yieldparam batch [Batch] collects regions to draw
+      def batch
+        @batch ||= Batch.new self
+        yield @batch
+        @batch.flush
+      end
+
+      # @api internal
+      def to_ptr
+        @pointer
+      end
+
+      # Collects regions of an {Atlas} to draw together
+      class Batch
+        # Floats per queued region, see SpriteBatch::draw
+        Stride = 8
+
+        def initialize atlas
+          @atlas = atlas
+          @pointer = Native.spritebatch_new
+          @quads = atlas.pages.map { [] }
+          @buffer = nil
+        end
+
+        # Queue a region to be drawn
+        #
+        # @overload draw source, x, y
+        # @overload draw source, x, y, scale
+        # @overload draw source, x, y, width, height
+        def draw source, x, y, w=nil, h=nil
+          page, sx, sy, sw, sh = @atlas[source]
+
+          if not w.present?
+            w, h = sw, sh
+          elsif not h.present?
+            w, h = sw * w, sh * w
+          end
+
+          @quads[page].push sx, sy, sw, sh, x.to_f, y.to_f, w.to_f, h.to_f
+        end
+
+        # Draw and forget everything queued so far
+        #
+        # @api internal
+        def flush
+          @quads.each_with_index do |quads, page|
+            next if quads.empty?
+
+            # reuse the buffer between frames, growing it as needed
+            if @buffer.nil? or @buffer.size < quads.size * 4
+              @buffer = FFI::MemoryPointer.new :float, quads.size
+            end
+
+            @buffer.put_array_of_float 0, quads
+            Native.spritebatch_draw @pointer, @atlas.pages[page].to_ptr, @buffer, quads.size / Stride
+            quads.clear
+          end
+
+          nil
+        end
+      end
+
+      private
+
+      def digest image
+        channels = Image::Native.ofpixels_getNumChannels Image::Native.ofimage_getPixelsRef(image.to_ptr)
+        bytes = Image::Native.ofimage_getPixels(image.to_ptr).get_bytes(0, image.width.to_i * image.height.to_i * channels)
+        Cache.key image.width, image.height, channels, bytes
+      end
+
+      def pack images
+        count = images.size
+        rects = FFI::MemoryPointer.new :int, count * 5
+        rects.put_array_of_int 0, images.map { |i| [i.width.to_i, i.height.to_i, 0, 0, 0] }.flatten
+        page_count = Native.textureatlas_pack @pointer, rects, count
+
+        regions = rects.get_array_of_int(0, count * 5).each_slice(5).map { |w, h, page, x, y| [page, x, y, w, h] }
+        if regions.any? { |page, *| page < 0 }
+          raise ArgumentError, "image larger than atlas page"
+        end
+
+        pages = page_count.times.map do
+          page = Image.new
+          Native.textureatlas_allocate @pointer, page.to_ptr
+          page
+        end
+
+        images.zip(regions).each do |image, (page, x, y, w, h)|
+          Native.textureatlas_blit @pointer, pages[page].to_ptr, Image::Native.ofimage_getPixelsRef(image.to_ptr), x, y
+        end
+        pages.each { |page| Image::Native.ofimage_update page.to_ptr }
+
+        [regions, pages]
+      end
+
+      # @api internal
+      module Native
+        extend FFI::Cpp::Library
+        ffi_lib File.expand_path("lib/libzajal.so", File.dirname(__FILE__))
+
+        ofImage = type(:ofImage_).template(:unsigned_char).actually(:ofImage)
+        ofPixels = type(:ofPixels_).template(:unsigned_char).actually(:ofPixels)
+        typedef :pointer, :ofImage
+        typedef :pointer, :ofPixels
+
+        attach_constructor :TextureAtlas, 12, []
+        attach_method :TextureAtlas, :setup, [:int, :int, :int], :void
+        attach_method :TextureAtlas, :pack, [type(:int).pointer.actually(:pointer), :int], :int
+        attach_method :TextureAtlas, :allocate, [ofImage.reference], :void
+        attach_method :TextureAtlas, :blit, [ofImage.reference, ofPixels.reference, :int, :int], :void
+
+        attach_constructor :SpriteBatch, 48, []
+        attach_method :SpriteBatch, :draw, [ofImage.reference, type(:float).pointer.actually(:pointer), :int], :void
+      end
+    end
+  end
+end
@@ -0,0 +1,253 @@
+module Zajal
+  # A packed array of floats in native memory
+  #
+  # Bulk methods like {Mathematics#noise_field} write into buffers and
+  # drawing methods like {Graphics#points} read straight out of them, so
+  # large amounts of data never have to pass through Ruby arrays.
+  #
+  # Each element is +components+ floats, e.g. 2 for x, y points.
+  #
+  # @example Points along a noisy line
+  #   line = Buffer.new 500, 2
+  #   heights = noise_field 500, step:0.01, time:time
+  #   500.times { |i| line[i] = [i, heights[i] * height] }
+  #   points line
+  #
+  # @api zajal
+  class Buffer
+    include Enumerable
+
+    # Primitives a buffer can be drawn as, see {#draw}
+    Modes = {
+      points:     0x0000,
+      lines:      0x0001,
+      line_loop:  0x0002,
+      line_strip: 0x0003,
+      triangles:  0x0004
+    }
+
+    # @return [Fixnum] number of elements
+    attr_reader :size
+    alias :length :size
+
+    # @return [Fixnum] floats per element
+    attr_reader :components
+
+    # Make a zeroed buffer
+    #
+    # @param size [#to_i] number of elements
+    # @param components [#to_i] floats per element
+    def initialize size=0, components=1
+      @components = components.to_i
+      raise ArgumentError, "components must be at least 1" if @components < 1
+
+      @pointer = nil
+      resize size
+    end
+
+    # Make a buffer holding +values+
+    #
+    # @param values [Array<Numeric>,Array<Array<Numeric>>] flat values, or
+    #   one array per element
+    def self.from values, components=nil
+      components ||= values.first.is_a?(Array) ? values.first.size : 1
+      values = values.flatten
+      buffer = new values.size / components, components
+      buffer.to_ptr.put_array_of_float 0, values.map(&:to_f)
+      buffer
+    end
+
+    # Change the number of elements
+    #
+    # Memory is only reallocated when growing past what the buffer has held
+    # before, so resizing every frame is cheap. Existing elements are kept,
+    # new ones are zeroed.
+    def resize size
+      old_size, @size = @size.to_i, size.to_i
+      floats = [@size * @components, 1].max
+
+      if @pointer.nil? or @pointer.size < floats * 4
+        old = @pointer
+        @pointer = FFI::MemoryPointer.new :float, floats
+        @pointer.put_bytes 0, old.get_bytes(0, old_size * @components * 4) if old and old_size > 0
+      elsif @size > old_size
+        @pointer.put_bytes old_size * @components * 4, "\0" * ((@size - old_size) * @components * 4)
+      end
+
+      self
+    end
+
+    # @return [Float, Array<Float>] the element at +index+, an array when
+    #   there is more than one component
+    def [] index
+      index = check_index index
+      if @components == 1
+        @pointer.get_float32 index * 4
+      else
+        @pointer.get_array_of_float index * @components * 4, @components
+      end
+    end
+
+    # Replace the element at +index+
+    def []= index, value
+      index = check_index index
+      if @components == 1
+        @pointer.put_float32 index * 4, value.to_f
+      else
+        @pointer.put_array_of_float index * @components * 4, value.first(@components).map(&:to_f)
+      end
+    end
+
+    def each &blk
+      to_a.each &blk
+    end
+
+    # @return [Array] every element, copied out of native memory at once
+    def to_a
+      floats = @pointer.get_array_of_float 0, @size * @components
+      @components == 1 ? floats : floats.each_slice(@components).to_a
+    end
+
+    # Add to every element in place
+    #
+    # @param other [Buffer, Vector, Array<Numeric>, Numeric] a buffer of
+    #   the same shape to add element by element, or one value to add to
+    #   every element
+    def add! other
+      apply :add, other
+    end
+
+    # Subtract from every element in place
+    #
+    # @param other (see #add!)
+    def subtract! other
+      apply :subtract, other
+    end
+
+    # Multiply every element in place, component by component
+    #
+    # @param other (see #add!)
+    def multiply! other
+      other.is_a?(Numeric) ? scale!(other) : apply(:multiply, other)
+    end
+
+    # Divide every element in place, component by component
+    #
+    # @param other (see #add!)
+    def divide! other
+      other.is_a?(Numeric) ? scale!(1.0 / other) : apply(:divide, other)
+    end
+
+    # Multiply every component by +factor+ in place
+    def scale! factor
+      Native.vectorsScale @pointer, @size, @components, factor.to_f
+      self
+    end
+
+    # Scale every element to length 1 in place
+    def normalize!
+      Native.vectorsNormalize @pointer, @size, @components
+      self
+    end
+
+    # Transform every element by +matrix+ in place
+    #
+    # @param matrix [Mat4]
+    def transform! matrix
+      raise ArgumentError, "only buffers of 2 or 3 components can be transformed" unless [2, 3].include? @components
+      Native.vectorsTransform @pointer, @size, @components, matrix.to_ptr
+      self
+    end
+
+    # @param into [Buffer] reuse this buffer instead of making a new one
+    # @return [Buffer] the length of every element
+    def lengths into=nil
+      out = (into || Buffer.new).resize @size
+      Native.vectorsLengths out.to_ptr, @pointer, @size, @components
+      out
+    end
+
+    # @param other [Buffer] a buffer of the same shape
+    # @param into [Buffer] reuse this buffer instead of making a new one
+    # @return [Buffer] the dot product of every pair of elements
+    def dot other, into=nil
+      check_shape other
+      out = (into || Buffer.new).resize @size
+      Native.vectorsDot out.to_ptr, @pointer, other.to_ptr, @size, @components
+      out
+    end
+
+    # Draw the buffer's elements as vertices
+    #
+    # @param mode [Symbol] one of the keys of {Modes}
+    def draw mode=:points
+      raise ArgumentError, "only buffers of 2 or 3 components can be drawn" unless [2, 3].include? @components
+      Native.drawVertices @pointer, @size, @components, Modes.fetch(mode)
+    end
+
+    # @api internal
+    def to_ptr
+      @pointer
+    end
+
+    # @api internal
+    # @return [Array] where a {SpatialIndex} finds the first x, y and z,
+    #   the floats between one point and the next, and how many there are
+    def spatial_points
+      raise ArgumentError, "only buffers of 2 or 3 components can be indexed" unless [2, 3].include? @components
+      [@pointer, @pointer + 4, (@pointer + 8 if @components == 3), @components, @size]
+    end
+
+    private
+
+    Ops = { add:0, subtract:1, multiply:2, divide:3 }
+
+    def apply op, other
+      raise ArgumentError, "only buffers of up to 4 components support arithmetic" if @components > 4
+
+      if other.is_a? Buffer
+        check_shape other
+        Native.vectorsApply Ops[op], @pointer, other.to_ptr, @size, @components, false
+      else
+        values = other.is_a?(Numeric) ? [other] * @components : other.to_a
+        @operand ||= FFI::MemoryPointer.new :float, 4
+        @operand.put_array_of_float 0, (values.map(&:to_f) + [0.0] * 4).first(4)
+        Native.vectorsApply Ops[op], @pointer, @operand, @size, @components, true
+      end
+
+      self
+    end
+
+    def check_shape other
+      unless other.size == @size and other.components == @components
+        raise ArgumentError, "buffer of #{other.size}x#{other.components} doesn't match #{@size}x#{@components}"
+      end
+    end
+
+    def check_index index
+      index = index.to_i
+      index += @size if index < 0
+      raise IndexError, "index #{index} outside of buffer of size #{@size}" unless index >= 0 and index < @size
+      index
+    end
+
+    # @api internal
+    module Native
+      extend FFI::Cpp::Library
+      ffi_lib File.expand_path("lib/libzajal.so", File.dirname(__FILE__))
+
+      floats = type(:float).pointer.actually(:pointer)
+
+      attach_function :drawVertices, [floats, :int, :int, :int], :void
+
+      # the mangler can't abbreviate repeated float*s, so those are spelled out
+      attach_function :vectorsApply, :_Z12vectorsApplyiPfS_iib, [:int, :pointer, :pointer, :int, :int, :bool], :void
+      attach_function :vectorsScale, [floats, :int, :int, :float], :void
+      attach_function :vectorsNormalize, [floats, :int, :int], :void
+      attach_function :vectorsLengths, :_Z14vectorsLengthsPfS_ii, [:pointer, :pointer, :int, :int], :void
+      attach_function :vectorsDot, :_Z10vectorsDotPfS_S_ii, [:pointer, :pointer, :pointer, :int, :int], :void
+      attach_function :vectorsTransform, :_Z16vectorsTransformPfiiS_, [:pointer, :int, :int, :pointer], :void
+      attach_function :matrixMultiply, :_Z14matrixMultiplyPfS_S_, [:pointer, :pointer, :pointer], :void
+    end
+  end
+end
@@ -0,0 +1,41 @@
+require "digest/sha1"
+require "fileutils"
+
+module Zajal
+  # On-disk cache for things that are expensive to rebuild
+  # 
+  # Entries live under +~/.zajal/cache+, or under +$ZAJAL_CACHE+ if it is
+  # set, and are keyed by a hash of whatever they were built from. Nothing is
+  # ever invalidated, a changed source simply hashes to a new key.
+  # 
+  # @api internal
+  module Cache
+    # @return [String] the directory all cache entries live under
+    def self.root
+      ENV["ZAJAL_CACHE"] || File.expand_path("~/.zajal/cache")
+    end
+
+    # Path to a cache entry, creating its parent directories
+    # 
+    # @example
+    #   Cache.path "atlas", key, "layout" # => "~/.zajal/cache/atlas/9f2c.../layout"
+    # 
+    # @param parts [Array<#to_s>] path components under {.root}
+    # @return [String] absolute path to the entry
+    def self.path *parts
+      path = File.join(root, *parts.map(&:to_s))
+      FileUtils.mkpath File.dirname(path)
+      path
+    end
+
+    # Hash any number of strings into a cache key
+    # 
+    # @param parts [Array<#to_s>] the things the cached entry was built from
+    # @return [String] hex digest
+    def self.key *parts
+      digest = Digest::SHA1.new
+      parts.each { |p| digest << p.to_s << "\0" }
+      digest.hexdigest
+    end
+  end
+end
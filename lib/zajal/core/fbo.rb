@@ -1,9 +1,15 @@
 module Zajal
   module Graphics
     class Fbo
+      # Fbos outlive reloads of the sketch, and a reloaded sketch asking for
+      # one the same size gets it back, with whatever was last drawn in it,
+      # see {Zajal::Resources}.
       def initialize width, height, samples=0
-        @pointer = Native.offbo_new
-        Native.offbo_allocate @pointer, width.to_i, height.to_i, 0x1908, samples # GL_RGBA=0x1908
+        @pointer = Resources.fetch(:fbo, width.to_i, height.to_i, samples.to_i) do
+          pointer = Native.offbo_new
+          Native.offbo_allocate pointer, width.to_i, height.to_i, 0x1908, samples.to_i # GL_RGBA=0x1908
+          pointer
+        end
       end
 
       def to_ptr
@@ -26,8 +32,11 @@ module Zajal
 
       def use
         self.begin
-        yield
-        self.end
+        begin
+          yield
+        ensure
+          self.end
+        end
       end
 
       def width
@@ -72,8 +81,10 @@ module Zajal
       module Native
         extend FFI::Cpp::Library
         File.expand_path("lib/libof.so", File.dirname(__FILE__))
+        bind_lazily
 
         attach_constructor :ofFbo, 232, []
+        attach_destructor :ofFbo
         attach_method :ofFbo, :allocate, [:int, :int, :int, :int], :void
         attach_method :ofFbo, :begin, [:bool], :void
         attach_method :ofFbo, :end, [], :void
@@ -0,0 +1,85 @@
+module Zajal
+  # Watches a sketch's file for changes from a native thread
+  #
+  # The thread uses inotify where there is one (see src/FileWatcher.h), so
+  # asking whether the file changed is a memory read rather than a +stat+
+  # every frame, and editors that save by renaming a new file over the old
+  # one are noticed too. A burst of writes counts as one change once the
+  # file has been quiet for {Debounce} milliseconds.
+  #
+  # The watcher also remembers when each change started, so the frontend
+  # can measure how long a save takes to reach the screen, see
+  # {#record_latency}.
+  #
+  # @api internal
+  class FileWatcher
+    # milliseconds a file has to be quiet before a change counts
+    Debounce = (ENV["ZAJAL_WATCH_DEBOUNCE"] || 30).to_i
+
+    # how many latencies {.latencies} keeps
+    LatencyLimit = 100
+
+    # @return [Array<Float>] seconds from the last few saves to the first
+    #   frame drawn from them
+    def self.latencies
+      @latencies ||= []
+    end
+
+    # @return [String] the path being watched
+    attr_reader :path
+
+    # @param path [String] the file to watch
+    # @param debounce [Fixnum] milliseconds
+    def initialize path, debounce=Debounce
+      @path = path
+      @pointer = Native.filewatcher_new
+      raise IOError, "Can't watch #{path}" unless Native.filewatcher_watch @pointer, File.expand_path(path), debounce
+    end
+
+    # @return [Boolean] has the file changed since the last {#take_change}?
+    #   Reads the flag the watcher thread sets, without calling into it
+    def changed?
+      @pointer.get_int32(0) != 0
+    end
+
+    # Clear {#changed?}, to be called as the change is picked up
+    #
+    # @return [Boolean] had the file changed?
+    def take_change
+      Native.filewatcher_takeChange @pointer
+    end
+
+    # Note that the first frame from the last change has been drawn
+    #
+    # Keeps the time since the change started in {.latencies}, and in the
+    # trace as a +save_to_frame+ span when tracing.
+    #
+    # @return [Float] the latency in seconds
+    def record_latency
+      seconds = Native.filewatcher_secondsSinceChange @pointer
+      latencies = self.class.latencies
+      latencies.shift if latencies.size >= LatencyLimit
+      latencies << seconds
+      Trace.latency :save_to_frame, seconds
+      seconds
+    end
+
+    # Stop watching now, rather than when collected
+    def stop
+      Native.filewatcher_stop @pointer
+    end
+
+    # @api internal
+    module Native
+      extend FFI::Cpp::Library
+      ffi_lib File.expand_path("lib/libzajal.so", File.dirname(__FILE__))
+
+      attach_constructor :FileWatcher, 56, []
+      attach_destructor :FileWatcher
+      attach_method :FileWatcher, :watch, [:string, :int], :bool
+      attach_method :FileWatcher, :stop, [], :void
+      attach_method :FileWatcher, :takeChange, [], :bool
+      attach_method :FileWatcher, :secondsSinceChange, [], :double
+    end
+  end
+end
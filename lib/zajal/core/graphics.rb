@@ -61,6 +61,9 @@ module Zajal
     # 
     # @see #circle_resolution
     def circle *args
+      # vectors are already laid out as ofPoints, skip matching
+      return Native.ofCirclePoint(args.first.to_ptr, args.last.to_f) if args.size == 2 and Vector === args.first
+
       x = y = z = r = 0
 
       case args
@@ -187,6 +190,10 @@ module Zajal
     # 
     # @see #square
     def rectangle *args
+      if args.size == 3 and Vector === args.first
+        return Native.ofRectPoint(args[0].to_ptr, args[1].to_f, args[2].to_f)
+      end
+
       x, y, z, w, h = 0
 
       case args
@@ -257,6 +264,10 @@ module Zajal
     #     line a, b
     # 
     def line *args
+      if args.size == 2 and Vector === args.first and Vector === args.last
+        return Native.ofLinePoints(args.first.to_ptr, args.last.to_ptr)
+      end
+
       x1 = y1 = z1 = x2 = y2 = z2 = 0
 
       case args
@@ -372,9 +383,16 @@ module Zajal
     # @param y [Numeric] amount to move vertically
     # @param z [Numeric] amount to move in depth
     # 
+    # @overload translate vector
+    #   @param vector [Vec2, Vec3] amount to move
+    # 
     # @return [nil] Nothing
-    def translate x, y, z=0.0
-      Native.ofTranslate x.to_f, y.to_f, z.to_f
+    def translate x, y=nil, z=0.0
+      if Vector === x
+        Native.ofTranslatePoint x.to_ptr
+      else
+        Native.ofTranslate x.to_f, y.to_f, z.to_f
+      end
     end
 
     # Scale all subsequent drawing
@@ -598,6 +616,13 @@ module Zajal
         pop_matrix
     end
 
+    # Transform all subsequent drawing by a matrix
+    # 
+    # @param mat [Mat4] the transformation, applied before the current one
+    def multiply_matrix mat
+      Native.ofMultMatrix mat.to_ptr
+    end
+
     # @overload rectangle_mode mode
     #   @demo Rectangle modes
     #     rectangle_mode :corner
@@ -815,6 +840,10 @@ module Zajal
     # @overload triangle point_a, point_b, point_c
     # 
     def triangle *args
+      if args.size == 3 and args.all? { |a| Vector === a }
+        return Native.ofTrianglePoints(args[0].to_ptr, args[1].to_ptr, args[2].to_ptr)
+      end
+
       x1 = y1 = z1 = x2 = y2 = z2 = x3 = y3 = z3 = 0
 
       equilateral_algorithm = proc { |x, y, z, r|
@@ -902,6 +931,10 @@ module Zajal
     # @overload ellipse point, width, height
     # @overload ellipse x, y, dimentions
     def ellipse *args
+      if args.size == 3 and Vector === args.first
+        return Native.ofEllipsePoint(args[0].to_ptr, args[1].to_f, args[2].to_f)
+      end
+
       x = y = z = w = h = 0
 
       case args
@@ -1075,6 +1108,8 @@ module Zajal
     end
 
     def vertex *args
+      return Native.ofVertexPoint(args.first.to_ptr) if args.size == 1 and Vector === args.first
+
       x = y = z = 0
 
       case args
@@ -1266,6 +1301,85 @@ module Zajal
       shape { vertex x, y; vertex x, y+1 }
     end
 
+    # Draw every point in a buffer with a single draw call
+    #
+    # @demo Noisy scatter
+    #   pts = Buffer.new 200, 2
+    #   200.times { |i| pts[i] = [i / 2.0, noise(i * 0.1) * 100] }
+    #   points pts
+    #
+    # @param buffer [Buffer] points of 2 or 3 components
+    def points buffer
+      buffer.draw :points
+    end
+
+    # Draw lines between consecutive pairs of points in a buffer with a
+    # single draw call
+    #
+    # @param buffer [Buffer] line end points of 2 or 3 components
+    # @param mode [:lines, :line_strip, :line_loop] pair up points, or join
+    #   them all into one line
+    def lines buffer, mode=:lines
+      buffer.draw mode
+    end
+
+    # Draw a circle for every element of a buffer with one call
+    #
+    # Circles are still drawn one at a time, but natively, so this is much
+    # faster than calling {#circle} in a loop.
+    #
+    # @demo Bubbles
+    #   bubbles = random_field 50, min:[0, 0, 2], max:[100, 100, 10]
+    #   circles bubbles
+    #
+    # @param buffer [Buffer] circles of 3 components (x, y, radius), 4
+    #   (x, y, z, radius), or 8 (red, green, blue, alpha, x, y, z, radius)
+    #   to color each one
+    def circles buffer
+      batch buffer, 3 => :circles2d, 4 => :circles, 8 => :color_circles do |c|
+        if c.size == 8
+          Native.ofSetColor *c.first(4).map(&:to_i)
+          c = c.last 4
+        end
+        circle *c
+      end
+    end
+
+    # Draw a rectangle for every element of a buffer with one call
+    #
+    # @param buffer [Buffer] rectangles of 4 components (x, y, width,
+    #   height), or 8 (red, green, blue, alpha, x, y, width, height) to
+    #   color each one
+    def rectangles buffer
+      batch buffer, 4 => :rectangles, 8 => :color_rectangles do |r|
+        if r.size == 8
+          Native.ofSetColor *r.first(4).map(&:to_i)
+          r = r.last 4
+        end
+        rectangle *r
+      end
+    end
+
+    # @api internal
+    # Hand +buffer+ to the shim function for its number of components, or
+    # each of its elements to the block if the shim isn't built
+    def batch buffer, functions
+      function = functions[buffer.components]
+      raise ArgumentError, "expected a buffer of #{functions.keys.join(' or ')} components, got #{buffer.components}" unless function
+
+      if Shim.available?
+        Shim::Native.send function, buffer.to_ptr, buffer.size
+      else
+        buffer.each { |element| yield element }
+      end
+
+      # per-element colors leave the last one set, put the sketch's back
+      if buffer.components == 8 and @color
+        r, g, b, a = @color.to_rgb.to_a
+        Native.ofSetColor r.to_i, g.to_i, b.to_i, a.to_i
+      end
+    end
+
     # Reset graphics settings to Zajal's defaults
     def defaults
       alpha_blending false
@@ -1316,6 +1430,7 @@ module Zajal
       extend FFI::Cpp::Library
 
       File.expand_path("lib/libof.so", File.dirname(__FILE__))
+      bind_lazily
 
       enum :ofOrientation,
        [:default,
@@ -1348,6 +1463,8 @@ module Zajal
 
       typedef :pointer, :ofRectangle
       typedef :pointer, :ofStyle
+      typedef :pointer, :ofVec3f
+      typedef :pointer, :ofMatrix4x4
 
       # TODO technically, this is not a Graphics method. Move it.
       typedef :pointer, :ofAppBaseWindow
@@ -1381,6 +1498,8 @@ module Zajal
       attach_function :ofRotateX, [:float], :void
       attach_function :ofRotateY, [:float], :void
       attach_function :ofRotateZ, [:float], :void # rotate
+      attach_function :ofTranslatePoint, :ofTranslate, [type(:ofVec3f).const.reference], :void
+      attach_function :ofMultMatrix, [type(:ofMatrix4x4).const.reference], :void
 
       #  screen coordinates / default gl values
       attach_function :ofSetupGraphicDefaults, [], :void
@@ -1445,12 +1564,22 @@ module Zajal
       attach_function :ofLine, [:float, :float, :float, :float, :float, :float], :void
       attach_function :ofRect, [:float, :float, :float, :float, :float], :void
       attach_function :ofRectRounded, [:float, :float, :float, :float, :float, :float], :void
+      # the same, taking Vec2 and Vec3 storage as ofPoints. The mangler can't
+      # abbreviate repeated parameter types, so those are spelled out.
+      ofPoint = type(:ofVec3f).const.reference
+      attach_function :ofCirclePoint, :ofCircle, [ofPoint, :float], :void
+      attach_function :ofEllipsePoint, :ofEllipse, [ofPoint, :float, :float], :void
+      attach_function :ofRectPoint, :ofRect, [ofPoint, :float, :float], :void
+      attach_function :ofLinePoints, :_Z6ofLineRK7ofVec3fS1_, [:pointer, :pointer], :void
+      attach_function :ofTrianglePoints, :_Z10ofTriangleRK7ofVec3fS1_S1_, [:pointer, :pointer, :pointer], :void
+
       attach_function :ofCurve, [:float, :float, :float, :float, :float, :float, :float, :float, :float, :float, :float, :float], :void
       attach_function :ofBezier, [:float, :float, :float, :float, :float, :float, :float, :float, :float, :float, :float, :float], :void
 
       # polygons
       attach_function :ofBeginShape, [], :void
       attach_function :ofVertex, [:float, :float, :float], :void
+      attach_function :ofVertexPoint, :ofVertex, [type(:ofVec3f).reference], :void
       attach_function :ofCurveVertex, [:float, :float], :void
       attach_function :ofBezierVertex, [:float, :float, :float, :float, :float, :float, :float, :float, :float], :void
       attach_function :ofEndShape, [:bool], :void
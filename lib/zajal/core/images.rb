@@ -75,8 +75,14 @@ module Zajal
     # {Image} can represents an image file loaded off the disk and a drawing
     # surface.
     class Image
+      include Graphics::Filters
+
       # Create a new image object
       # 
+      # Images loaded from files outlive reloads of the sketch, and a
+      # reloaded sketch loading the same unchanged file gets the same image
+      # back without reading it again, see {Zajal::Resources}.
+      # 
       # @overload initialize
       # @overload initialize filename
       #   @param filename [#to_s] name of the file to load
@@ -88,13 +94,19 @@ module Zajal
       #   @param width [Numeric] width of the new image
       #   @param width [Numeric] height of the new image
       def initialize *args
-        @pointer = Native.ofimage_new
-
         case args
         when Signature[]
+          @pointer = Native.ofimage_new
         when Signature[:to_s]
-          load args.first
+          path = File.expand_path(args.first.to_s)
+          @resource_key = [:image, path, File.exist?(path) && File.mtime(path)]
+          @pointer = Resources.fetch(*@resource_key) do
+            pointer = Native.ofimage_new
+            Native.ofimage_loadImage pointer, path.to_ptr
+            pointer
+          end
         when Signature[:to_i, :to_i]
+          @pointer = Native.ofimage_new
           resize *args
         else
           raise ArgumentError, args.inspect
@@ -110,6 +122,7 @@ module Zajal
       # 
       # @todo fix cwd bug in ofImage::loadImage!!
       def load filename
+        changed
         path = File.expand_path(filename.to_s)
         Native.ofimage_loadImage @pointer, path.to_ptr
       end
@@ -126,6 +139,7 @@ module Zajal
       # @overload grab_screen x, y
       # @overload grab_screen x, y, width, height
       def grab_screen *args
+        changed
         x, y = 0, 0
         w, h = Sketch.current.width, Sketch.current.height
 
@@ -160,6 +174,7 @@ module Zajal
       #     img.resize 100, 50
       #     img.draw 0, 0
       def resize w, h=nil
+        changed
         h = w unless h.present?
         Native.ofimage_resize @pointer, w.to_i, h.to_i
       end
@@ -203,6 +218,7 @@ module Zajal
       end
 
       def crop x, y, w, h
+        changed
         Native.ofimage_crop @pointer, x.to_i, y.to_i, w.to_i, h.to_i
       end
 
@@ -211,6 +227,7 @@ module Zajal
       # @overload rotate
       # @overload rotate times
       def rotate times=1
+        changed
         Native.ofimage_rotate90 @pointer, times.to_i
       end
 
@@ -219,6 +236,7 @@ module Zajal
       # @overload mirror
       # @overload mirror direction
       def mirror direction=:horizontal
+        changed
         d = {
           horizontal: [false, true],
           vertical:[true, false],
@@ -229,16 +247,46 @@ module Zajal
         Native.ofimage_mirror @pointer, *d
       end
 
+      # @api internal
+      def to_ptr
+        @pointer
+      end
+
+      # The image isn't what it was loaded as anymore, so it's not to be
+      # reused by a reloaded sketch
+      # 
+      # @api internal
+      def changed
+        Resources.forget @resource_key, @pointer if @resource_key
+        @resource_key = nil
+      end
+
+      # @api internal
+      def pixels_pointer
+        Native.ofimage_getPixelsRef @pointer
+      end
+
+      # Reupload the edited pixels to the texture
+      # 
+      # @api internal
+      def pixels_changed
+        changed
+        Native.ofimage_update @pointer
+        self
+      end
+
       # @api internal
       module Native
         extend FFI::Cpp::Library
         File.expand_path("lib/libof.so", File.dirname(__FILE__))
+        bind_lazily
 
         ofImage = type(:ofImage_).template(:unsigned_char).actually(:ofImage)
 
         enum :ofImageQualityType, [ :best, :high, :medium, :low, :worst ]
 
         attach_constructor ofImage, 152, []
+        attach_destructor ofImage
         attach_method ofImage, :draw, [:float, :float, :float, :float, :float], :void
         attach_method ofImage, :loadImage, [:stdstring], :bool
         attach_method ofImage, :saveImage, [:stdstring, :ofImageQualityType], :bool
@@ -251,6 +299,14 @@ module Zajal
         attach_method ofImage, :crop, [:int, :int, :int, :int], :void
         attach_method ofImage, :rotate90, [:int], :void
         attach_method ofImage, :mirror, [:bool, :bool], :void
+
+        attach_method ofImage, :getPixels, [], :pointer
+        attach_method ofImage, :getPixelsRef, [], :pointer
+        attach_method ofImage, :update, [], :void
+
+        ofPixels = type(:ofPixels_).template(:unsigned_char).actually(:ofPixels)
+        # const method, which the mangler doesn't know about yet
+        attach_method ofPixels, :getNumChannels, [], :int, :_ZNK9ofPixels_IhE14getNumChannelsEv
       end
     end
 
@@ -0,0 +1,254 @@
+module Zajal
+  # Many particles, simulated and drawn natively
+  #
+  # Keeping particles as Ruby objects and moving them in +update+ tops out
+  # at a few thousand. A {Particles} system keeps every particle's
+  # position, velocity, age and color in native arrays, moves them all with
+  # one call to {#update}, and draws them all with one call to {#draw}.
+  #
+  # Particles are moved by forces added with {#gravity}, {#drag},
+  # {#attractor} and {#noise}, and disappear once they outlive their life.
+  #
+  # @example Sparks following the mouse
+  #   setup do
+  #     @sparks = Particles.new 50000
+  #     @sparks.gravity 0, 200
+  #     @sparks.drag 0.5
+  #     @sparks.noise scale:0.01, strength:80
+  #   end
+  #
+  #   update do
+  #     @sparks.emit 200, x:mouse_x, y:mouse_y, speed:150, life:2, color: :orange
+  #     @sparks.update
+  #   end
+  #
+  #   draw do
+  #     @sparks.draw :points, size:2, fade:true
+  #   end
+  #
+  # @api zajal
+  class Particles
+    # Floats per emitted particle, see ParticleSystem::emit
+    Stride = 9
+
+    Kinds = { gravity:0, drag:1, attractor:2, noise:3 }
+    Modes = { points:0, quads:1 }
+
+    # A force acting on a {Particles} system, kept to change it later
+    class Force
+      def initialize particles, index, values
+        @particles = particles
+        @index = index
+        @values = values
+      end
+
+      # Change the force's parameters, in the order its constructor took them
+      def set *values
+        @values[0, values.size] = values.map(&:to_f)
+        Native.particlesystem_setForce @particles.to_ptr, @index, *@values
+        self
+      end
+
+      # Move an attractor
+      def move x, y
+        set x, y
+      end
+    end
+
+    # @return [Fixnum] the most particles that can be alive at once
+    attr_reader :capacity
+
+    # @param capacity [#to_i] the most particles that can be alive at once
+    def initialize capacity=10000
+      @capacity = capacity.to_i
+      @pointer = Native.particlesystem_new
+      Native.particlesystem_setup @pointer, @capacity
+
+      @clock = 0.0
+      @last_update = nil
+      @records = nil
+    end
+
+    # Accelerate every particle the same way
+    #
+    # @overload gravity strength
+    #   Straight down
+    # @overload gravity x, y
+    # @return [Force]
+    def gravity x, y=nil
+      x, y = 0, x unless y.present?
+      add_force :gravity, x, y
+    end
+
+    # Slow every particle down
+    #
+    # @param amount [Numeric] fraction of velocity lost per second
+    # @return [Force]
+    def drag amount
+      add_force :drag, amount
+    end
+
+    # Pull particles toward a point, more strongly the closer they are
+    #
+    # @param x [Numeric] x coordinate of the point
+    # @param y [Numeric] y coordinate of the point
+    # @option options [Numeric] :strength (1000) negative to push away
+    # @option options [Numeric] :radius (0) only affect particles this
+    #   close, 0 for all of them
+    # @return [Force] call {Force#move} to move the point
+    def attractor x, y, options={}
+      options = { strength:1000, radius:0 }.merge options
+      add_force :attractor, x, y, options[:strength], options[:radius]
+    end
+
+    # Push particles around a flowing noise field
+    #
+    # @option options [Numeric] :scale (0.01) smaller values make smoother
+    #   fields
+    # @option options [Numeric] :strength (50) acceleration at the field's
+    #   strongest
+    # @option options [Numeric] :speed (0.5) how fast the field changes
+    # @return [Force]
+    def noise options={}
+      options = { scale:0.01, strength:50, speed:0.5 }.merge options
+      add_force :noise, options[:scale], options[:strength], options[:speed]
+    end
+
+    # Remove every force
+    def clear_forces
+      Native.particlesystem_clearForces @pointer
+      self
+    end
+
+    # Add particles
+    #
+    # Particles past {#capacity} are dropped.
+    #
+    # @param count [#to_i] how many to add
+    # @option options [Numeric] :x (0) where to start
+    # @option options [Numeric] :y (0) where to start
+    # @option options [Array<Numeric>] :velocity starting velocity, shared
+    #   by every particle
+    # @option options [Numeric] :speed (0) fly off in random directions at
+    #   up to this speed instead
+    # @option options [Numeric] :life (0) seconds to live, 0 for forever
+    # @option options [Object] :color (:white) anything {Graphics#color}
+    #   accepts
+    # @return [Fixnum] how many were added
+    def emit count=1, options={}
+      options = { x:0, y:0, speed:0, life:0, color: :white }.merge options
+      count = count.to_i
+      return 0 if count <= 0
+
+      x, y, life = options[:x].to_f, options[:y].to_f, options[:life].to_f
+      r, g, b, a = *Color.new(:rgb, *options[:color]).to_rgb.to_a.map { |c| c / 255.0 }
+
+      if options[:velocity].present?
+        vx, vy = options[:velocity]
+        record = [x, y, vx.to_f, vy.to_f, life, r, g, b, a]
+
+        # reuse the buffer between frames, growing it as needed
+        if @records.nil? or @records.size < count * Stride * 4
+          @records = FFI::MemoryPointer.new :float, count * Stride
+        end
+
+        @records.put_array_of_float 0, record * count
+        Native.particlesystem_emit @pointer, @records, count
+      else
+        Native.particlesystem_burst @pointer, count, x, y, options[:speed].to_f, life, r, g, b, a
+      end
+    end
+
+    # Apply forces and move every particle
+    #
+    # @param dt [Numeric] seconds to advance, defaults to the time since the
+    #   last update
+    def update dt=nil
+      now = ::Time.now.to_f
+      dt ||= @last_update.nil? ? 1 / 60.0 : now - @last_update
+      @last_update = now
+      @clock += dt.to_f
+
+      Native.particlesystem_update @pointer, dt.to_f, @clock
+      self
+    end
+
+    # Draw every particle with a single draw call
+    #
+    # @param mode [:points, :quads]
+    # @option options [Numeric] :size (1) pixels across
+    # @option options [Boolean] :fade (false) fade out over each particle's
+    #   life?
+    def draw mode=:points, options={}
+      options = { size:1, fade:false }.merge options
+      Native.particlesystem_draw @pointer, Modes.fetch(mode), options[:size].to_f, options[:fade].to_bool
+    end
+
+    # @return [Fixnum] how many particles are alive
+    def count
+      Native.particlesystem_getCount @pointer
+    end
+    alias :size :count
+
+    # Positions of every particle
+    #
+    # @param into [Buffer] reuse this buffer instead of making a new one,
+    #   it must have 2 components
+    # @return [Buffer] x, y pairs
+    def positions into=nil
+      raise ArgumentError, "expected a buffer of 2 components, got #{into.components}" if into and into.components != 2
+      buffer = into || Buffer.new(0, 2)
+      buffer.resize count
+      Native.particlesystem_copyPositions @pointer, buffer.to_ptr
+      buffer
+    end
+
+    # Remove every particle
+    def clear
+      Native.particlesystem_clear @pointer
+      self
+    end
+
+    # @api internal
+    def to_ptr
+      @pointer
+    end
+
+    # @api internal
+    # @see Buffer#spatial_points
+    def spatial_points
+      [Native.particlesystem_getX(@pointer), Native.particlesystem_getY(@pointer), nil, 1, count]
+    end
+
+    private
+
+    def add_force kind, *values
+      values = (values.map(&:to_f) + [0.0] * 4).first(4)
+      index = Native.particlesystem_addForce @pointer, Kinds[kind], *values
+      Force.new self, index, values
+    end
+
+    # @api internal
+    module Native
+      extend FFI::Cpp::Library
+      ffi_lib File.expand_path("lib/libzajal.so", File.dirname(__FILE__))
+
+      floats = type(:float).pointer.actually(:pointer)
+
+      attach_constructor :ParticleSystem, 344, []
+      attach_method :ParticleSystem, :setup, [:int], :void
+      attach_method :ParticleSystem, :emit, [floats, :int], :int
+      attach_method :ParticleSystem, :burst, [:int, :float, :float, :float, :float, :float, :float, :float, :float], :int
+      attach_method :ParticleSystem, :addForce, [:int, :float, :float, :float, :float], :int
+      attach_method :ParticleSystem, :setForce, [:int, :float, :float, :float, :float], :void
+      attach_method :ParticleSystem, :clearForces, [], :void
+      attach_method :ParticleSystem, :update, [:float, :float], :void
+      attach_method :ParticleSystem, :draw, [:int, :float, :bool], :void
+      attach_method :ParticleSystem, :copyPositions, [floats], :void
+      attach_method :ParticleSystem, :getX, [], :pointer
+      attach_method :ParticleSystem, :getY, [], :pointer
+      attach_method :ParticleSystem, :getCount, [], :int
+      attach_method :ParticleSystem, :clear, [], :void
+    end
+  end
+end
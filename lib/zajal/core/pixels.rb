@@ -1,6 +1,78 @@
 module Zajal
   module Graphics
+    # Image processing on raw pixels
+    # 
+    # Mixed into {Pixels} and {Images::Image}. Everything runs natively and
+    # in place, using SIMD and splitting large images across threads.
+    # Includers provide +pixels_pointer+, the ofPixels to operate on, and
+    # can override +pixels_changed+ to react to edits.
+    # 
+    # @api zajal
+    module Filters
+      # Blur with a box filter
+      # 
+      # @param radius [#to_i] how many pixels in every direction to average
+      def blur radius
+        Kernels.pixelkernels_boxBlur Kernels.shared, pixels_pointer, radius.to_i
+        pixels_changed
+      end
+
+      # Blur with a gaussian filter
+      # 
+      # @param sigma [#to_f] standard deviation of the filter, in pixels
+      def gaussian_blur sigma
+        Kernels.pixelkernels_gaussianBlur Kernels.shared, pixels_pointer, sigma.to_f
+        pixels_changed
+      end
+
+      # Convolve with a square kernel
+      # 
+      # @example Sharpen
+      #   img.convolve [[ 0, -1,  0],
+      #                 [-1,  5, -1],
+      #                 [ 0, -1,  0]]
+      # 
+      # @param kernel [Array<Array<Numeric>>] 3x3 or 5x5 weights
+      def convolve kernel
+        weights = kernel.flatten.map(&:to_f)
+        size = Math.sqrt(weights.size).to_i
+        raise ArgumentError, "kernel must be square with an odd size" unless size * size == weights.size and size.odd?
+
+        buffer = FFI::MemoryPointer.new :float, weights.size
+        buffer.put_array_of_float 0, weights
+        Kernels.pixelkernels_convolve Kernels.shared, pixels_pointer, buffer, size
+        pixels_changed
+      end
+
+      # Replace colors with their brightness
+      def grayscale
+        Kernels.pixelkernels_grayscale Kernels.shared, pixels_pointer
+        pixels_changed
+      end
+
+      # Make colors above +level+ white and everything else black
+      # 
+      # @param level [0..255] the cutoff
+      def threshold level=127
+        Kernels.pixelkernels_threshold Kernels.shared, pixels_pointer, level.to_i
+        pixels_changed
+      end
+
+      # Multiply colors by their alpha
+      def premultiply
+        Kernels.pixelkernels_premultiply Kernels.shared, pixels_pointer
+        pixels_changed
+      end
+
+      # @api internal
+      def pixels_changed
+        self
+      end
+    end
+
     class Pixels
+      include Filters
+
       def initialize
         @pointer = Native.ofpixels_new
       end
@@ -9,6 +81,21 @@ module Zajal
         @pointer
       end
 
+      # Resample the pixels to a new size
+      # 
+      # @overload resize size
+      # @overload resize width, height
+      def resize w, h=nil
+        h = w unless h.present?
+        Kernels.pixelkernels_resize Kernels.shared, @pointer, w.to_i, h.to_i
+        self
+      end
+
+      # @api internal
+      def pixels_pointer
+        @pointer
+      end
+
       def << other
         case other
         when Fbo
@@ -27,15 +114,41 @@ module Zajal
       module Native
         extend FFI::Cpp::Library
         File.expand_path("lib/libof.so", File.dirname(__FILE__))
+        bind_lazily
 
         enum :ofImageQualityType, [ :best, :high, :medium, :low, :worst ]
         ofPixels = type(:ofPixels_).template(:unsigned_char).actually(:ofPixels)
         typedef :pointer, :ofPixels
 
         attach_constructor ofPixels, 24, []
+        attach_destructor ofPixels
 
         attach_function :ofSaveImage, [ofPixels.reference, :stdstring, :ofImageQualityType], :void
       end
     end
+
+    # @api internal
+    module Kernels
+      extend FFI::Cpp::Library
+      ffi_lib File.expand_path("lib/libzajal.so", File.dirname(__FILE__))
+
+      ofPixels = type(:ofPixels_).template(:unsigned_char).actually(:ofPixels)
+      typedef :pointer, :ofPixels
+
+      attach_constructor :PixelKernels, 24, []
+      attach_method :PixelKernels, :boxBlur, [ofPixels.reference, :int], :void
+      attach_method :PixelKernels, :gaussianBlur, [ofPixels.reference, :float], :void
+      attach_method :PixelKernels, :convolve, [ofPixels.reference, type(:float).pointer.actually(:pointer), :int], :void
+      attach_method :PixelKernels, :grayscale, [ofPixels.reference], :void
+      attach_method :PixelKernels, :threshold, [ofPixels.reference, :int], :void
+      attach_method :PixelKernels, :premultiply, [ofPixels.reference], :void
+      attach_method :PixelKernels, :resize, [ofPixels.reference, :int, :int], :void
+
+      # The kernels keep scratch memory around between calls, so everyone
+      # shares one instance
+      def self.shared
+        @shared ||= pixelkernels_new
+      end
+    end
   end
 end
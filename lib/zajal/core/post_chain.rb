@@ -0,0 +1,151 @@
+module Zajal
+  module Graphics
+    # A chain of full screen shader passes
+    #
+    # The scene is captured once into the chain, and each pass draws the
+    # output of the one before it through its shader. The chain owns a small
+    # pool of same-sized framebuffers and ping-pongs between them, so adding
+    # passes doesn't allocate anything.
+    #
+    # A pass whose input and uniforms are the same as last time it ran is
+    # skipped, and its previous output is reused. Uniform values can be
+    # procs, which are called every frame to get the current value. Texture
+    # uniforms are compared by identity, not content.
+    #
+    # The input of each pass is bound to texture unit 0, which is where
+    # sampler uniforms point unless told otherwise.
+    #
+    # @example Blur then vignette
+    #   chain = PostChain.new width, height
+    #   chain.pass blur, direction: [1.0, 0.0]
+    #   chain.pass blur, direction: [0.0, 1.0]
+    #   chain.pass vignette, strength: -> { sin(time) }
+    #
+    #   draw do
+    #     chain.capture { circle 50, 50, 20 }
+    #     chain.draw
+    #   end
+    class PostChain
+      # The buffer the scene is captured into
+      Source = 0
+
+      # Buffers for pass output. Three is enough to ping-pong while keeping
+      # the output of the last skipped pass alive.
+      Intermediates = 1..3
+
+      Pass = Struct.new :shader, :uniforms, :target, :signature, :version, :skipped
+
+      # @param width [#to_i] width of every buffer
+      # @param height [#to_i] height of every buffer
+      def initialize width, height
+        @pointer = Native.postchain_new
+        Native.postchain_setup @pointer, width.to_i, height.to_i, Intermediates.last + 1
+
+        @passes = []
+        @owners = {}
+        @source_version = 0
+        @output = Source
+      end
+
+      # Add a pass to the end of the chain
+      #
+      # @param shader [Shader] the shader to draw the previous output through
+      # @param uniforms [Hash] uniforms to set, values may be procs
+      # @return [PostChain] self
+      def pass shader, uniforms={}
+        @passes << Pass.new(shader, uniforms, nil, nil, 0, false)
+        self
+      end
+
+      # Render the scene into the chain and run it
+      #
+      # @yield draws the scene
+      def capture
+        Native.postchain_begin @pointer, Source
+        yield
+        Native.postchain_end @pointer, Source
+        @source_version += 1
+
+        apply
+      end
+
+      # Run every pass whose input or uniforms changed since it last ran
+      #
+      # {#capture} calls this, call it directly to rerun the chain on a scene
+      # that hasn't changed, e.g. when only uniforms are animated.
+      def apply
+        input, input_version = Source, @source_version
+        pinned = Source
+        dirty = false
+
+        @passes.each_with_index do |pass, i|
+          values = Hash[pass.uniforms.map { |name, value| [name, value.respond_to?(:call) ? value.call : value] }]
+          signature = [input_version, values]
+
+          # once one pass runs, everything after it has new input anyway
+          pass.skipped = (not dirty and pass.signature == signature and @owners[pass.target] == [i, pass.version])
+
+          if pass.skipped
+            pinned = pass.target
+          else
+            dirty = true
+            target = (Intermediates.to_a - [input, pinned]).first
+
+            Native.postchain_beginPass @pointer, i, target
+            pass.shader.use do
+              pass.shader.uniforms values unless values.empty?
+              Native.postchain_drawBuffer @pointer, input
+            end
+            Native.postchain_endPass @pointer, i, target
+
+            pass.target = target
+            pass.signature = signature
+            pass.version += 1
+            @owners[target] = [i, pass.version]
+          end
+
+          input, input_version = pass.target, [i, pass.version]
+        end
+
+        @output = input
+      end
+
+      # Draw the output of the last pass
+      def draw x=0, y=0
+        Native.postchain_draw @pointer, @output, x.to_f, y.to_f
+      end
+
+      # How long each pass took the last time it ran
+      #
+      # GPU times lag a frame or more behind, and are nil where the driver
+      # has no timer queries.
+      #
+      # @return [Array<Hash>] +:shader+, +:skipped+, +:cpu+ and +:gpu+ for
+      #   each pass, times in milliseconds
+      def timings
+        @passes.each_with_index.map do |pass, i|
+          cpu = Native.postchain_getCpuTime @pointer, i
+          gpu = Native.postchain_getGpuTime @pointer, i
+          { shader:pass.shader, skipped:pass.skipped, cpu:(cpu < 0 ? nil : cpu), gpu:(gpu < 0 ? nil : gpu) }
+        end
+      end
+
+      # @api internal
+      module Native
+        extend FFI::Cpp::Library
+        ffi_lib File.expand_path("lib/libzajal.so", File.dirname(__FILE__))
+
+        attach_constructor :PostChain, 176, []
+        attach_method :PostChain, :setup, [:int, :int, :int], :void
+        attach_method :PostChain, :begin, [:int], :void
+        attach_method :PostChain, :end, [:int], :void
+        attach_method :PostChain, :beginPass, [:int, :int], :void
+        attach_method :PostChain, :drawBuffer, [:int], :void
+        attach_method :PostChain, :endPass, [:int, :int], :void
+        attach_method :PostChain, :draw, [:int, :float, :float], :void
+        attach_method :PostChain, :getCpuTime, [:int], :float
+        attach_method :PostChain, :getGpuTime, [:int], :float
+      end
+    end
+  end
+end
@@ -0,0 +1,141 @@
+module Zajal
+  # A seedable stream of random numbers
+  #
+  # Two streams made with the same seed and stream number always produce
+  # the same numbers, so a sketch drawn from them comes out the same every
+  # time it runs, however much other randomness it uses. Streams with
+  # different stream numbers are independent, so separate parts of a
+  # sketch can each have their own.
+  #
+  # Numbers come from xoshiro256** by default, or PCG32. Filling a
+  # {Buffer} happens natively in one call, which makes thousands of random
+  # numbers a frame cheap.
+  #
+  # @example The same stars every time
+  #   setup do
+  #     @sky = RandomStream.new 1969
+  #     @stars = @sky.fill Buffer.new(500, 2), [0, 0], [width, height]
+  #   end
+  #
+  #   draw do
+  #     points @stars
+  #   end
+  #
+  # @see Mathematics#random_field
+  # @api zajal
+  class RandomStream
+    Generators = { xoshiro:0, pcg:1 }
+
+    # @return [Fixnum] the seed the stream started from
+    attr_reader :seed
+
+    # @param seed [#to_i] defaults to a different seed every run
+    # @option options [#to_i] :stream (0) which of the seed's independent
+    #   streams to use
+    # @option options [Symbol] :generator (:xoshiro) +:xoshiro+ or +:pcg+
+    def initialize seed=nil, options={}
+      @pointer = Native.randomstream_new
+      @stream = (options[:stream] || 0).to_i
+      @generator = options[:generator] || :xoshiro
+      reseed seed
+    end
+
+    # Start the stream over
+    #
+    # @param seed [#to_i] defaults to the seed it started from
+    def reseed seed=@seed
+      @seed = (seed || rand(2 ** 32)).to_i & 0xffffffff
+      Native.randomstream_seed @pointer, @seed, @stream & 0xffffffff, Generators.fetch(@generator)
+      self
+    end
+
+    # @return [Float] a number from +low+ up to but not including +high+
+    def uniform low=0.0, high=1.0
+      Native.randomstream_uniform @pointer, low.to_f, high.to_f
+    end
+
+    # @return [Float] a number from a normal distribution
+    def normal mean=0.0, deviation=1.0
+      Native.randomstream_normal @pointer, mean.to_f, deviation.to_f
+    end
+
+    # @return [Fixnum] a whole number from +low+ to +high+, including both
+    def integer low, high
+      Native.randomstream_integer @pointer, low.to_i, high.to_i
+    end
+
+    # Fill a buffer with uniform numbers
+    #
+    # +low+ and +high+ can be arrays with a range for each component.
+    #
+    # @param buffer [Buffer]
+    # @return [Buffer] +buffer+
+    def fill buffer, low=0.0, high=1.0
+      each_component(buffer, low, high) do |pointer, count, stride, l, h|
+        Native.randomstream_fillUniform @pointer, pointer, count, stride, l.to_f, h.to_f
+      end
+    end
+
+    # Fill a buffer from a normal distribution
+    #
+    # @param buffer [Buffer]
+    # @param mean [Numeric, Array<Numeric>]
+    # @param deviation [Numeric, Array<Numeric>]
+    # @return [Buffer] +buffer+
+    def fill_normal buffer, mean=0.0, deviation=1.0
+      each_component(buffer, mean, deviation) do |pointer, count, stride, m, d|
+        Native.randomstream_fillNormal @pointer, pointer, count, stride, m.to_f, d.to_f
+      end
+    end
+
+    # Fill a buffer with whole numbers from +low+ to +high+, including both.
+    # Buffers hold floats, so numbers past 2**24 lose precision.
+    #
+    # @param buffer [Buffer]
+    # @param low [Fixnum, Array<Fixnum>]
+    # @param high [Fixnum, Array<Fixnum>]
+    # @return [Buffer] +buffer+
+    def fill_integers buffer, low, high
+      each_component(buffer, low, high) do |pointer, count, stride, l, h|
+        Native.randomstream_fillIntegers @pointer, pointer, count, stride, l.to_i, h.to_i
+      end
+    end
+
+    # @api internal
+    def to_ptr
+      @pointer
+    end
+
+    private
+
+    # one fill per component, so each can have its own parameters
+    def each_component buffer, a, b
+      stride = buffer.components
+      if a.is_a? Array or b.is_a? Array
+        a = Array(a) * stride if a.is_a? Numeric
+        b = Array(b) * stride if b.is_a? Numeric
+        stride.times { |c| yield buffer.to_ptr + c * 4, buffer.size, stride, a[c], b[c] }
+      else
+        yield buffer.to_ptr, buffer.size * stride, 1, a, b
+      end
+      buffer
+    end
+
+    # @api internal
+    module Native
+      extend FFI::Cpp::Library
+      ffi_lib File.expand_path("lib/libzajal.so", File.dirname(__FILE__))
+
+      floats = type(:float).pointer.actually(:pointer)
+
+      attach_constructor :RandomStream, 48, []
+      attach_method :RandomStream, :seed, [:uint, :uint, :int], :void
+      attach_method :RandomStream, :uniform, [:float, :float], :float
+      attach_method :RandomStream, :normal, [:float, :float], :float
+      attach_method :RandomStream, :integer, [:int, :int], :int
+      attach_method :RandomStream, :fillUniform, [floats, :int, :int, :float, :float], :void
+      attach_method :RandomStream, :fillNormal, [floats, :int, :int, :float, :float], :void
+      attach_method :RandomStream, :fillIntegers, [floats, :int, :int, :int, :int], :void
+    end
+  end
+end
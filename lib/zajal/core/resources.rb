@@ -0,0 +1,100 @@
+require "weakref"
+
+module Zajal
+  # Native resources kept alive across reloads
+  #
+  # Reloading a sketch used to throw away every image, font, fbo and shader
+  # it made, only for the new code's setup to make the same ones again.
+  # Instead, {Image}s loaded from files, {Font}s, {Fbo}s and linked
+  # {Shader} programs are made through {.fetch}, keyed by what they were
+  # made from. When a sketch reloads, the old sketch's resources become
+  # spares, and the new code gets a spare back rather than a new one
+  # whenever it asks for the same thing. Spares nobody asked for are let go
+  # once the new sketch has set up.
+  #
+  # A resource that has changed since it was made, e.g. an image that was
+  # resized or filtered, is {.forget}ten, so it's never handed to code
+  # expecting a fresh one. An fbo comes back with whatever was last drawn
+  # into it. Set ZAJAL_FRESH_RESOURCES to make everything anew every reload.
+  #
+  # The running sketch's resources are only held weakly, so ones it drops
+  # are still collected as before.
+  #
+  # @api internal
+  module Resources
+    @live = {}
+    @spare = {}
+    @enabled = !ENV.key?("ZAJAL_FRESH_RESOURCES")
+
+    class << self
+      # @return [Boolean] are resources kept across reloads?
+      attr_accessor :enabled
+    end
+
+    # A resource for +key+, a spare one if there is one, otherwise the
+    # block's
+    #
+    # @example
+    #   @pointer = Resources.fetch(:fbo, width, height, samples) { make_fbo }
+    #
+    # @param key [Array] what the resource is made from, starting with its
+    #   kind
+    # @yieldreturn the new resource, usually a native pointer
+    # @return the resource
+    def self.fetch *key
+      return yield unless @enabled
+
+      spares = @spare[key]
+      resource = spares && spares.pop || yield
+      live = @live[key] ||= []
+      live.select! { |ref| ref.weakref_alive? }
+      live << WeakRef.new(resource)
+      resource
+    end
+
+    # Never hand +resource+ out again, it changed since it was made
+    #
+    # @param key [Array] the key it was fetched with
+    def self.forget key, resource
+      live = @live[key]
+      live.delete_if { |ref| not ref.weakref_alive? or ref.__getobj__.equal? resource } if live
+    end
+
+    # Make resources without keeping them, for the frontends' own
+    def self.unkept
+      enabled, @enabled = @enabled, false
+      yield
+    ensure
+      @enabled = enabled
+    end
+
+    # Load a new sketch, offering it the current sketch's resources
+    #
+    # If the block raises, the current sketch is still running, so it keeps
+    # its resources and the failed sketch's are dropped.
+    #
+    # @yield loads the new sketch
+    # @return the block's value
+    def self.reload
+      live = @live
+      @spare = Hash[@live.map { |key, refs| [key, alive(refs)] }]
+      @live = {}
+      yield
+    rescue ScriptError, StandardError
+      @live, @spare = live, {}
+      raise
+    end
+
+    # Let go of the spares the new sketch didn't take, for the garbage
+    # collector to free
+    def self.release_spares
+      @spare = {}
+    end
+
+    # @return [Array] what +refs+ still refer to
+    def self.alive refs
+      refs.map { |ref| ref.__getobj__ rescue nil }.compact
+    end
+    private_class_method :alive
+  end
+end
@@ -1,19 +1,76 @@
+require "weakref"
+
 module Zajal
   module Graphics
     class Shader
+      @@linked = {}
+      @@binary_cache = true
+
+      # Turn the on-disk program binary cache on or off
+      # 
+      # Shaders are still shared within the process either way.
+      # 
+      # @param enabled [Boolean]
+      def self.binary_cache= enabled
+        @@binary_cache = enabled
+      end
+
+      # Compile and link a shader
+      # 
+      # Linked programs are cached by source. Creating a shader with the same
+      # source as a live one reuses its program, which also means the two
+      # share uniform values. A program is deleted once no shader uses it,
+      # except that a reloaded sketch is offered the old sketch's programs
+      # first, see {Zajal::Resources}. Where the driver supports it, the
+      # linked binary is also saved under {Zajal::Cache}, and later runs load
+      # it instead of compiling.
+      # 
+      # @param vertex [#to_s] vertex shader source
+      # @param fragment [#to_s] fragment shader source
       def initialize vertex, fragment
-        @pointer = Native.ofshader_new
-        Native.ofshader_setupShaderFromSource @pointer, Native::Vertex, vertex.to_s.to_ptr
-        Native.ofshader_setupShaderFromSource @pointer, Native::Fragment, fragment.to_s.to_ptr
-        Native.ofshader_linkProgram @pointer
+        key = Cache.key vertex, fragment
+        @linked = Shader.linked(key) || Resources.fetch(:shader, key) { load_binary(vertex, fragment) || compile(vertex, fragment) }
+        Shader.link key, @linked
+        @pointer, @program, @uniform_cache = @linked
+
+        @uniforms = {}
+        @texture_units = 0
+      end
+
+      # @return [Array, nil] the live program linked from sources hashing to
+      #   +key+
+      # 
+      # @api internal
+      def self.linked key
+        ref = @@linked[key]
+        ref.__getobj__ if ref and ref.weakref_alive?
+      rescue WeakRef::RefError
+        nil
+      end
+
+      # Share +linked+ with later shaders of the same source, for as long as
+      # a shader holds on to it
+      # 
+      # @api internal
+      def self.link key, linked
+        @@linked.delete_if { |k, ref| not ref.weakref_alive? }
+        @@linked[key] = WeakRef.new linked
       end
 
       def begin
-        Native.ofshader_begin @pointer
+        if @pointer
+          Native.ofshader_begin @pointer
+        else
+          Binaries.shaderbinaries_begin Binaries.shared, @program
+        end
       end
 
       def end
-        Native.ofshader_end @pointer
+        if @pointer
+          Native.ofshader_end @pointer
+        else
+          Binaries.shaderbinaries_end Binaries.shared
+        end
       end
 
       def use
@@ -22,21 +79,235 @@ module Zajal
         self.end
       end
 
+      # A prebound uniform
+      # 
+      # The uniform's location and type are looked up once, so holding on to
+      # the handle and calling {Uniform#set} is the cheapest way to update a
+      # uniform every frame.
+      # 
+      # @example
+      #   blur = Shader.new vertex, fragment
+      #   amount = blur[:amount]
+      #   
+      #   draw do
+      #     amount.set sin(time)
+      #     blur.use { image "photo.jpg", 0, 0 }
+      #   end
+      # 
+      # @param name [#to_s] the uniform's name in the shader source
+      # @return [Uniform] handle to the uniform
+      def [] name
+        @uniforms[name.to_sym] ||= Uniform.new self, name
+      end
+
+      # Set a uniform
+      # 
+      # @overload uniform name, *values
+      #   @param name [#to_s] the uniform's name
+      #   @param values [Array<Numeric>, Array<Array<Numeric>>] as many values
+      #     as the uniform's type has components, or arrays of them for array
+      #     uniforms
+      # @overload uniform name, texture
+      #   @param texture [#texture] anything with a texture, like an {Fbo}
+      # 
+      # @see Uniform#set
       def uniform name, *args
-        if args.count == 1 and args.first.respond_to? :texture
-            Native.ofshader_setUniformTexture @pointer, name.to_s, args.first.texture, 10
-        else
-            raise "uniform must have 1-4 arguments, given #{args.count}!" if args.count == 0 || args.count > 4
-            raise "uniform arguments must all be integers or floats!" unless args.all? { |a| a.is_a? Fixnum } or args.all? { |a| a.is_a? Float }
+        self[name].set *args
+      end
+
+      # Set many uniforms in one native call
+      # 
+      # @example
+      #   shader.uniforms time: time, resolution: [width, height], colors: [[1, 0, 0], [0, 0, 1]]
+      # 
+      # @param values [Hash] uniform names and their values
+      def uniforms values
+        records = []
+        values.each do |name, value|
+          uniform = self[name]
+          if uniform.sampler?
+            uniform.set value
+          else
+            records << uniform.record(*value)
+          end
+        end
+
+        upload records
+      end
+
+      # @api internal
+      def to_ptr
+        @pointer
+      end
+
+      # @api internal
+      def uniform_cache
+        @uniform_cache
+      end
+
+      # Texture unit for the next sampler uniform. Unit 0 is left for
+      # whatever is being drawn.
+      # 
+      # @api internal
+      def next_texture_unit
+        @texture_units += 1
+      end
+
+      # @return [Fixnum] the GL program id
+      # @api internal
+      def program
+        @program
+      end
+
+      # Upload records built by {Uniform#record}
+      # 
+      # @api internal
+      def upload records
+        return if records.empty?
+
+        ints = records.map(&:first).flatten
+        floats = records.map(&:last).flatten
+
+        # reuse the buffers between frames, growing them as needed
+        @record_buffer = FFI::MemoryPointer.new :int, ints.size if @record_buffer.nil? or @record_buffer.size < ints.size * 4
+        @value_buffer = FFI::MemoryPointer.new :float, floats.size if @value_buffer.nil? or @value_buffer.size < floats.size * 4
+
+        @record_buffer.put_array_of_int 0, ints
+        @value_buffer.put_array_of_float 0, floats unless floats.empty?
+        UniformCache.shaderuniforms_upload @uniform_cache, @record_buffer, @value_buffer, records.size
+      end
+
+      private
+
+      def compile vertex, fragment
+        pointer = Native.ofshader_new
+        Native.ofshader_setupShaderFromSource pointer, Native::Vertex, vertex.to_s.to_ptr
+        Native.ofshader_setupShaderFromSource pointer, Native::Fragment, fragment.to_s.to_ptr
+        program = Native.ofshader_getProgram(pointer).get_uint32(0)
+        Binaries.shaderbinaries_prepare Binaries.shared, program if @@binary_cache
+        Native.ofshader_linkProgram pointer
+
+        Binaries.shaderbinaries_save Binaries.shared, program, binary_path(vertex, fragment) if @@binary_cache
+
+        [pointer, program, uniform_cache_for(program)]
+      end
 
-            method = "ofshader_setUniform#{args.count}#{args.first.is_a?(Fixnum) ? 'i' : 'f'}"
-            Native.send method.to_sym, @pointer, name.to_s, *args
+      def load_binary vertex, fragment
+        return nil unless @@binary_cache and Binaries.shaderbinaries_isSupported(Binaries.shared)
+
+        program = Binaries.shaderbinaries_load Binaries.shared, binary_path(vertex, fragment)
+        [nil, program, uniform_cache_for(program), owned_program(program)] unless program.zero?
+      end
+
+      # A loaded program has no ofShader to delete it, so this does when
+      # it's collected
+      def owned_program program
+        memory = FFI::Cpp::Owned.malloc 1
+        memory.put_uint32 0, program
+        FFI::Cpp::Owned.new memory, :ShaderProgram, lambda { |m| Binaries.shaderbinaries_unload Binaries.shared, m.get_uint32(0) }
+      end
+
+      # binaries are only good for the driver that made them
+      def binary_path vertex, fragment
+        Cache.path "shaders", Cache.key(Binaries.shaderbinaries_getDriver(Binaries.shared), vertex, fragment)
+      end
+
+      def uniform_cache_for program
+        cache = UniformCache.shaderuniforms_new
+        UniformCache.shaderuniforms_setup cache, program
+        cache
+      end
+
+      public
+
+      # A uniform in a linked {Shader}
+      # 
+      # @see Shader#[]
+      class Uniform
+        # GL uniform types and the kind and number of components they take
+        Types = {
+          0x1406 => [:float, 1],   0x8B50 => [:float, 2],  0x8B51 => [:float, 3],  0x8B52 => [:float, 4],
+          0x1404 => [:int, 1],     0x8B53 => [:int, 2],    0x8B54 => [:int, 3],    0x8B55 => [:int, 4],
+          0x8B56 => [:int, 1],     0x8B57 => [:int, 2],    0x8B58 => [:int, 3],    0x8B59 => [:int, 4], # bools
+          0x8B5A => [:matrix, 4],  0x8B5B => [:matrix, 9], 0x8B5C => [:matrix, 16]
+        }
+
+        # sampler1D through sampler2DRectShadow
+        Samplers = 0x8B5D..0x8B64
+
+        # See ShaderUniformKind
+        Kinds = { float:0, int:1, matrix:2 }
+
+        attr_reader :name, :location, :length
+
+        def initialize shader, name
+          @shader = shader
+          @name = name.to_s
+          @location = -1
+          @length = 1
+
+          info = FFI::MemoryPointer.new :int, 3
+          if UniformCache.shaderuniforms_describe shader.uniform_cache, @name, info
+            @location, type, @length = info.get_array_of_int 0, 3
+
+            if Samplers.include? type
+              @unit = shader.next_texture_unit
+            else
+              @kind, @components = Types[type]
+              raise ArgumentError, "uniform #{@name} has unsupported type 0x#{type.to_s(16)}" if @kind.nil?
+            end
+          end
+        end
+
+        # Does the shader actually use this uniform?
+        # 
+        # GLSL compilers drop uniforms that don't affect the output. Setting
+        # one of those does nothing.
+        def active?
+          @location >= 0
+        end
+
+        def sampler?
+          not @unit.nil?
+        end
+
+        # Set the uniform's value
+        # 
+        # @example
+        #   shader[:time].set time
+        #   shader[:center].set 0.5, 0.5
+        #   shader[:weights].set [0.2, 0.5, 0.2]
+        #   shader[:transform].set matrix
+        #   shader[:image].set fbo
+        def set *args
+          if sampler?
+            raise ArgumentError, "sampler #{@name} needs something with a texture" unless args.first.respond_to? :texture
+            UniformCache.shaderuniforms_setTexture @shader.uniform_cache, @location, args.first.texture, @unit
+          elsif active?
+            @shader.upload [record(*args)]
+          end
+        end
+
+        # Pack values for {Shader#upload}
+        # 
+        # @api internal
+        def record *args
+          return [[-1, 0, 1, 0], []] unless active?
+
+          values = args.map { |a| a.respond_to?(:to_a) ? a.to_a : a }.flatten
+          count = values.size / @components
+          if values.empty? or values.size % @components != 0 or count > @length
+            raise ArgumentError, "uniform #{@name} takes #{@length > 1 ? "up to #{@length} sets of " : ''}#{@components} values, given #{values.size}!"
+          end
+
+          [[@location, Kinds[@kind], @components, count], values.map(&:to_f)]
         end
       end
 
       module Native
         extend FFI::Cpp::Library
         File.expand_path("lib/libof.so", File.dirname(__FILE__))
+        bind_lazily
 
         typedef :pointer, :ofTexture
 
@@ -45,6 +316,7 @@ module Zajal
         Geometry = 0x8DD9
 
         attach_constructor :ofShader, 64, []
+        attach_destructor :ofShader
 
         attach_method :ofShader, :load, [:stdstring, :stdstring, :stdstring], :bool
 
@@ -74,17 +346,20 @@ module Zajal
         attach_method :ofShader, :setUniform4f, [:string, :float, :float, :float, :float], :void
 
         # set an array of uniform values
-        # attach_method :ofShader, :setUniform1iv, [:string, :int v, :int = 1], :void
-        # attach_method :ofShader, :setUniform2iv, [:string, :int v, :int = 1], :void
-        # attach_method :ofShader, :setUniform3iv, [:string, :int v, :int = 1], :void
-        # attach_method :ofShader, :setUniform4iv, [:string, :int v, :int = 1], :void
+        intArray = type(:int).const.pointer.actually(:pointer)
+        attach_method :ofShader, :setUniform1iv, [:string, intArray, :int], :void
+        attach_method :ofShader, :setUniform2iv, [:string, intArray, :int], :void
+        attach_method :ofShader, :setUniform3iv, [:string, intArray, :int], :void
+        attach_method :ofShader, :setUniform4iv, [:string, intArray, :int], :void
 
-        # attach_method :ofShader, :setUniform1fv, [:string, :float v, :int = 1], :void
-        # attach_method :ofShader, :setUniform2fv, [:string, :float v, :int = 1], :void
-        # attach_method :ofShader, :setUniform3fv, [:string, :float v, :int = 1], :void
-        # attach_method :ofShader, :setUniform4fv, [:string, :float v, :int = 1], :void
+        floatArray = type(:float).const.pointer.actually(:pointer)
+        attach_method :ofShader, :setUniform1fv, [:string, floatArray, :int], :void
+        attach_method :ofShader, :setUniform2fv, [:string, floatArray, :int], :void
+        attach_method :ofShader, :setUniform3fv, [:string, floatArray, :int], :void
+        attach_method :ofShader, :setUniform4fv, [:string, floatArray, :int], :void
 
-        # attach_method :ofShader, :setUniformMatrix4f, [:string, const ofMatrix4x4 & m], :void
+        typedef :pointer, :ofMatrix4x4
+        attach_method :ofShader, :setUniformMatrix4f, [:string, type(:ofMatrix4x4).const.reference], :void
 
         # set attributes that vary per vertex (look up the location before glBegin)
         attach_method :ofShader, :getAttributeLocation, [:string], :int
@@ -115,6 +390,43 @@ module Zajal
 
         # links program with all compiled shaders
         attach_method :ofShader, :linkProgram, [], :bool
+
+        attach_method :ofShader, :getProgram, [], :pointer
+      end
+
+      # @api internal
+      module UniformCache
+        extend FFI::Cpp::Library
+        ffi_lib File.expand_path("lib/libzajal.so", File.dirname(__FILE__))
+
+        typedef :pointer, :ofTexture
+
+        attach_constructor :ShaderUniforms, 80, []
+        attach_destructor :ShaderUniforms
+        attach_method :ShaderUniforms, :setup, [:uint], :int
+        attach_method :ShaderUniforms, :describe, [:string, type(:int).pointer.actually(:pointer)], :bool
+        attach_method :ShaderUniforms, :upload, [type(:int).pointer.actually(:pointer), type(:float).pointer.actually(:pointer), :int], :void
+        attach_method :ShaderUniforms, :setTexture, [:int, type(:ofTexture).reference, :int], :void
+      end
+
+      # @api internal
+      module Binaries
+        extend FFI::Cpp::Library
+        ffi_lib File.expand_path("lib/libzajal.so", File.dirname(__FILE__))
+
+        attach_constructor :ShaderBinaries, 32, []
+        attach_method :ShaderBinaries, :isSupported, [], :bool
+        attach_method :ShaderBinaries, :getDriver, [], :string
+        attach_method :ShaderBinaries, :prepare, [:uint], :void
+        attach_method :ShaderBinaries, :save, [:uint, :string], :bool
+        attach_method :ShaderBinaries, :load, [:string], :uint
+        attach_method :ShaderBinaries, :unload, [:uint], :void
+        attach_method :ShaderBinaries, :begin, [:uint], :void
+        attach_method :ShaderBinaries, :end, [], :void
+
+        def self.shared
+          @shared ||= shaderbinaries_new
+        end
       end
     end
   end
@@ -0,0 +1,29 @@
+require "zajal/core/shim/spec"
+
+module Zajal
+  module Shim
+    # @return [Boolean] has libzajalshim.so been built? Callers fall back to
+    #   libof's functions when it hasn't.
+    def self.available?
+      Native.available
+    end
+
+    # functions in +libzajalshim.so+, named as in the spec
+    # @api internal
+    module Native
+      extend FFI::Cpp::Library
+
+      class << self
+        attr_reader :available
+      end
+
+      path = File.expand_path("lib/libzajalshim.so", File.dirname(__FILE__))
+      @available = File.exist? path
+
+      if @available
+        ffi_lib path
+        Entries.each_value { |entry| attach_c_function entry.name, entry.symbol, entry.ffi_params, entry.returns }
+      end
+    end
+  end
+end
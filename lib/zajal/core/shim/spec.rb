@@ -0,0 +1,81 @@
+module Zajal
+  # Entry points of libzajalshim.so, a thin extern "C" library over hot
+  # openFrameworks calls
+  #
+  # The shim's source is generated from the declarations below by
+  # +rake shim+ in core/src, and {Shim::Native} binds the same declarations,
+  # so the two can't disagree. Bound with plain C linkage, shim functions
+  # skip mangling and symbol guessing, and two kinds of entry point do more
+  # per call than openFrameworks' own functions can:
+  #
+  # * fused ones run several functions with one call, like setting the
+  #   color and drawing a circle
+  # * batched ones run a function once for every element of a float array,
+  #   so a whole {Buffer} of circles costs one call from Ruby
+  module Shim
+    # @api internal
+    # An entry point. Batched ones have +source+, the entry they repeat.
+    Entry = Struct.new(:name, :params, :returns, :body, :source) do
+      def symbol
+        "zajal_#{name}"
+      end
+
+      # @return [Array<Symbol>] FFI types of the C function's parameters
+      def ffi_params
+        source ? [:pointer, :int] : params.values
+      end
+
+      def batched?
+        !source.nil?
+      end
+    end
+
+    Entries = {}
+
+    # Declare a function
+    #
+    # @param name [Symbol]
+    # @param params [Hash{Symbol => Symbol}] parameter names and types
+    # @param body [String] the C++ statements to run
+    # @param returns [Symbol]
+    def self.function name, params, body, returns=:void
+      Entries[name] = Entry.new(name, params, returns, body)
+    end
+
+    # Declare a function that runs others in order, taking all their
+    # parameters
+    def self.fused name, *names
+      parts = names.map { |n| Entries.fetch n }
+      params = parts.map(&:params).inject do |all, more|
+        clash = all.keys & more.keys
+        raise ArgumentError, "#{name} fuses two parameters called #{clash.join(', ')}" unless clash.empty?
+        all.merge more
+      end
+
+      Entries[name] = Entry.new(name, params, :void, parts.map(&:body).join("\n"))
+    end
+
+    # Declare a function that runs +source+ once for each group of floats in
+    # an array, one float per parameter
+    def self.batched name, source
+      source = Entries.fetch source
+      raise ArgumentError, "can't batch #{source.name}, it returns #{source.returns}" unless source.returns == :void
+
+      Entries[name] = Entry.new(name, source.params, :void, source.body, source)
+    end
+
+    function :color, { r: :int, g: :int, b: :int, a: :int }, "ofSetColor(r, g, b, a);"
+    function :circle, { x: :float, y: :float, z: :float, radius: :float }, "ofCircle(x, y, z, radius);"
+    function :circle2d, { x: :float, y: :float, radius: :float }, "ofCircle(x, y, radius);"
+    function :rectangle, { x: :float, y: :float, w: :float, h: :float }, "ofRect(x, y, w, h);"
+
+    fused :color_circle, :color, :circle
+    fused :color_rectangle, :color, :rectangle
+
+    batched :circles, :circle
+    batched :circles2d, :circle2d
+    batched :color_circles, :color_circle
+    batched :rectangles, :rectangle
+    batched :color_rectangles, :color_rectangle
+  end
+end
@@ -131,6 +131,79 @@ module Zajal
       bare
     end
 
+    # A reloaded sketch file, read and checked off the run loop
+    # 
+    # Reading the file, checking its syntax and working out whether it's
+    # bare all happen on a thread of their own, at a lower priority than the
+    # run loop, so the window keeps drawing meanwhile. Once {#ready?}, the
+    # frontend swaps it in at the next frame boundary with
+    # {Sketch#refresh_with}, which only has to evaluate the code.
+    # 
+    # It is an ordinary Ruby thread though, so it still takes turns with the
+    # run loop for the interpreter lock. Reading the file lets go of the
+    # lock, but checking the syntax holds it, so a large sketch can still
+    # make the frames around a save a little slower. It just never stalls
+    # a single frame for the whole of it.
+    # 
+    # @api internal
+    class Preparation
+      # @return [File] the file the code was read from
+      attr_reader :file
+
+      # @return [String] the code in the file
+      attr_reader :code
+
+      # @return [Boolean] is the code bare, see {Sketch.bare?}
+      attr_reader :bare
+
+      # @return [Exception, nil] why the code can't be loaded, e.g. a
+      #   SyntaxError
+      attr_reader :error
+
+      # Start preparing +path+
+      # 
+      # @param path [String] the sketch file
+      # @param sketch_class [Class] the class to run {Sketch.bare?} on
+      def initialize path, sketch_class
+        @thread = Thread.new do
+          begin
+            @file = File.open(path)
+            @code = @file.read
+            Preparation.check_syntax @code
+            @bare = sketch_class.bare? @code
+            Preparation.check_syntax sketch_class.bare_source(@code) if @bare
+          rescue ScriptError, StandardError => e
+            @error = e
+          end
+        end
+        @thread.priority = -3
+      end
+
+      # @return [Boolean] is it prepared, successfully or not?
+      def ready?
+        not @thread.alive?
+      end
+
+      # Wait until {#ready?}
+      # 
+      # @return [Preparation] self
+      def wait
+        @thread.join
+        self
+      end
+
+      # Compile +code+ without running it
+      # 
+      # @raise [SyntaxError] if it doesn't parse
+      def self.check_syntax code
+        if defined? RubyVM::InstructionSequence
+          RubyVM::InstructionSequence.compile code
+        else
+          catch(:valid) { eval "BEGIN { throw :valid }\n#{code}" }
+        end
+      end
+    end
+
     # Create a new {Sketch} object
     # 
     # A sketch can be created from Zajal code in a string, a File object
@@ -144,7 +217,11 @@ module Zajal
     # The event blocks in the code are exposed as instance methods as
     # described in {Sketch.support_event}.
     # 
-    # @param code_or_file [#to_s,File] the code to load or file to watch
+    # A {Preparation} loads like its file, without reading or parsing it
+    # again.
+    # 
+    # @param code_or_file [#to_s,File,Preparation] the code to load or file
+    #   to watch
     # 
     # @todo Iron out custom events
     # 
@@ -152,6 +229,17 @@ module Zajal
     def initialize code_or_file=nil, &blk
       if blk
         instance_eval &blk
+      elsif code_or_file.is_a? Preparation
+        @file = code_or_file.file
+        @file_last_modified = @file.mtime
+        @code = code_or_file.code
+        @bare = code_or_file.bare
+
+        if @bare
+          execute_bare @code
+        else
+          execute @code
+        end
       else
         if code_or_file.is_a? File
           @file = code_or_file
@@ -182,28 +270,102 @@ module Zajal
     end
 
     def execute_bare code
-      instance_eval "draw do; #{code}\nend"
+      instance_eval Sketch.bare_source(code)
+    end
+
+    # @return [String] bare +code+ wrapped in a draw block
+    def self.bare_source code
+      "draw do; #{code}\nend"
+    end
+
+    # The {FileWatcher} on the sketch's file, started on first use
+    # 
+    # @return [FileWatcher, nil] nil if the sketch has no file, or it can't
+    #   be watched natively
+    def watcher
+      return nil if @file.nil? or @watcher == false
+
+      @watcher ||= FileWatcher.new @file.path
+    rescue IOError, FFI::NotFoundError, LoadError
+      @watcher = false
+      nil
     end
 
     # @return [Boolean] has the watched file has been updated?
     def stale?
-      @file.nil? ? false : @file.mtime > @file_last_modified
+      return false if @file.nil?
+
+      w = watcher
+      w ? w.changed? : @file.mtime > @file_last_modified
     end
 
     # Refresh sketch and keep the sketch running going
     def refresh_continue
       return nil if @file.nil?
 
+      watcher.take_change if watcher
       sk = self.class.new open(@file.path)
       sk.copy_instance_variables_from self, [:@setup_proc, :@draw_proc, :@update_proc, :@file_last_modified]
       sk
     end
 
     # Reload the file and start the sketch over
+    # 
+    # The new sketch takes over this one's {#watcher}.
     def refresh_restart
       return nil if @file.nil?
 
-      self.class.new open(@file.path)
+      preparation = prepare_refresh
+      preparation && refresh_with(preparation.wait)
+    end
+
+    # Start reading the changed file on another thread
+    # 
+    # Picks up the change, so {#stale?} is false until the file changes
+    # again.
+    # 
+    # @return [Preparation, nil] nil if the sketch has no file
+    def prepare_refresh
+      return nil if @file.nil?
+
+      if watcher
+        watcher.take_change
+      else
+        @file_last_modified = @file.mtime
+      end
+
+      Preparation.new @file.path, self.class
+    end
+
+    # Start a prepared sketch over in place of this one
+    # 
+    # The new sketch takes over this one's {#watcher}, and is offered this
+    # one's images, fonts, fbos and shaders as it loads and sets up, see
+    # {Resources}. Call {Resources.release_spares} once it has set up.
+    # 
+    # @param preparation [Preparation] a ready preparation of this sketch's
+    #   file
+    # @yield [sketch] sets the new sketch up, before this one lets go of
+    #   anything
+    # 
+    # @raise [ScriptError, StandardError] if the file couldn't be prepared,
+    #   or its code or the block raised. Keep running this sketch then.
+    def refresh_with preparation
+      raise preparation.error if preparation.error
+
+      sk = Resources.reload do
+        new_sketch = self.class.new preparation
+        yield new_sketch if block_given?
+        new_sketch
+      end
+      sk.watcher = @watcher unless @watcher.nil?
+      sk
+    end
+
+    # @api private
+    def watcher= watcher
+      @watcher.stop if @watcher and not @watcher.equal? watcher
+      @watcher = watcher
     end
 
     # @see http://apidock.com/rails/Object/copy_instance_variables_from
@@ -0,0 +1,191 @@
+module Zajal
+  # Common ground of {SpatialHash} and {KdTree}
+  #
+  # An index finds the points near a place without checking every point,
+  # which turns flocking and collision sketches that compare every point
+  # with every other from O(n²) into roughly O(n).
+  #
+  # Indexes read their points straight out of a {Buffer} of 2 or 3
+  # components or a {Particles} system, without copying them, and answer
+  # with point indices into the same buffer or system. They don't notice
+  # points moving by themselves, so call {#refresh} once the points have
+  # moved, which costs much less than making a new index.
+  #
+  # @example Connect nearby particles
+  #   setup do
+  #     @dust = Particles.new 2000
+  #     @dust.noise strength:20
+  #     @dust.emit 2000, x:width / 2, y:height / 2, speed:100
+  #     @index = SpatialHash.new @dust, 20
+  #   end
+  #
+  #   update do
+  #     @dust.update
+  #     @index.refresh
+  #     @positions = @dust.positions @positions
+  #   end
+  #
+  #   draw do
+  #     @index.neighbourhoods(20).each_with_index do |neighbours, i|
+  #       neighbours.each { |j| line *@positions[i], *@positions[j] if j > i }
+  #     end
+  #   end
+  #
+  # @api zajal
+  class SpatialIndex
+    # @return [Fixnum] how many points are indexed
+    attr_reader :size
+
+    # Index a different set of points
+    #
+    # Needed after resizing a buffer that was being indexed, since that can
+    # move its memory. {#refresh} does this on its own when it notices.
+    #
+    # @param points [Buffer, Particles]
+    def load points
+      @points = points
+      x, y, z, stride, @size = points.spatial_points
+      @layout = [x, y, z, stride]
+      native :load, x, y, z, stride, @size
+      self
+    end
+
+    # Catch up with points that moved, or were added or removed at the end
+    def refresh
+      x, y, z, stride, size = @points.spatial_points
+      return load(@points) unless [x, y, z, stride] == @layout
+
+      @size = size
+      native :refresh, @size
+      self
+    end
+
+    # @param point [Vec2, Vec3, Array<Numeric>, #x#y]
+    # @param radius [Numeric]
+    # @return [Array<Fixnum>] indices of the points within +radius+ of
+    #   +point+, in no particular order
+    def within point, radius
+      x, y, z = coordinates point
+      results native(:within, x, y, z, radius.to_f)
+    end
+
+    # @param point [Vec2, Vec3, Array<Numeric>, #x#y]
+    # @param count [#to_i] how many points to find
+    # @return [Array<Fixnum>] indices of the closest +count+ points to
+    #   +point+, closest first
+    def nearest point, count=1
+      x, y, z = coordinates point
+      results native(:nearest, x, y, z, count.to_i)
+    end
+
+    # Every point's neighbours, found in one call
+    #
+    # @param radius [Numeric]
+    # @return [Array<Array<Fixnum>>] for each point, the indices of the
+    #   other points within +radius+ of it
+    def neighbourhoods radius
+      flat = results native(:neighbourhoods, radius.to_f)
+      offsets = native(:getOffsets).get_array_of_int32 0, @size + 1
+      offsets.each_cons(2).map { |first, last| flat[first...last] }
+    end
+
+    # @api internal
+    def to_ptr
+      @pointer
+    end
+
+    private
+
+    def native name, *args
+      self.class::Native.send self.class::Calls[name], @pointer, *args
+    end
+
+    def coordinates point
+      x, y, z = point.respond_to?(:to_a) ? point.to_a : [point.x, point.y, (point.z if point.respond_to? :z)]
+      [x.to_f, y.to_f, z.to_f]
+    end
+
+    def results count
+      count.zero? ? [] : native(:getResults).get_array_of_int32(0, count)
+    end
+  end
+
+  # Points binned into a grid of square cells
+  #
+  # Cheap to keep up to date, so the one to use when points move every
+  # frame. Queries are fastest when their radius is around the cell size.
+  #
+  # @see SpatialIndex
+  class SpatialHash < SpatialIndex
+    # @param points [Buffer, Particles]
+    # @param cell_size [Numeric] width of a cell, best set to the radius
+    #   most queries use
+    def initialize points, cell_size
+      @pointer = Native.spatialhash_new
+      Native.spatialhash_setup @pointer, cell_size.to_f
+      load points
+    end
+
+    # Catch up with a single point that moved
+    #
+    # @param index [#to_i] the point's index
+    def update index
+      Native.spatialhash_update @pointer, index.to_i
+      self
+    end
+
+    Calls = Hash.new { |calls, name| calls[name] = :"spatialhash_#{name}" }
+
+    # @api internal
+    module Native
+      extend FFI::Cpp::Library
+      ffi_lib File.expand_path("lib/libzajal.so", File.dirname(__FILE__))
+
+      attach_constructor :SpatialHash, 280, []
+      attach_method :SpatialHash, :setup, [:float], :void
+      # the mangler can't abbreviate repeated float*s, so load is spelled out
+      attach_method :SpatialHash, :load, [:pointer, :pointer, :pointer, :int, :int], :void, :_ZN11SpatialHash4loadEPfS0_S0_ii
+      attach_method :SpatialHash, :refresh, [:int], :void
+      attach_method :SpatialHash, :update, [:int], :void
+      attach_method :SpatialHash, :within, [:float, :float, :float, :float], :int
+      attach_method :SpatialHash, :nearest, [:float, :float, :float, :int], :int
+      attach_method :SpatialHash, :neighbourhoods, [:float], :int
+      attach_method :SpatialHash, :getResults, [], :pointer
+      attach_method :SpatialHash, :getOffsets, [], :pointer
+    end
+  end
+
+  # Points split into a balanced k-d tree
+  #
+  # The one to use for {#nearest} queries, and for points bunched up in
+  # some places and sparse in others. {#refresh} stretches the tree around
+  # moved points rather than rebuilding it, so queries slow down as points
+  # wander far from where they were loaded. Call {#load} again every so
+  # often when they do.
+  #
+  # @see SpatialIndex
+  class KdTree < SpatialIndex
+    # @param points [Buffer, Particles]
+    def initialize points
+      @pointer = Native.kdtree_new
+      load points
+    end
+
+    Calls = Hash.new { |calls, name| calls[name] = :"kdtree_#{name}" }
+
+    # @api internal
+    module Native
+      extend FFI::Cpp::Library
+      ffi_lib File.expand_path("lib/libzajal.so", File.dirname(__FILE__))
+
+      attach_constructor :KdTree, 152, []
+      attach_method :KdTree, :load, [:pointer, :pointer, :pointer, :int, :int], :void, :_ZN6KdTree4loadEPfS0_S0_ii
+      attach_method :KdTree, :refresh, [:int], :void
+      attach_method :KdTree, :within, [:float, :float, :float, :float], :int
+      attach_method :KdTree, :nearest, [:float, :float, :float, :int], :int
+      attach_method :KdTree, :neighbourhoods, [:float], :int
+      attach_method :KdTree, :getResults, [], :pointer
+      attach_method :KdTree, :getOffsets, [], :pointer
+    end
+  end
+end
@@ -0,0 +1,183 @@
+#include "FileWatcher.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+// how often the polling fallback looks at the file, in milliseconds
+#define FILEWATCHER_POLL_INTERVAL 100
+
+static double watcherNow() {
+#ifdef __linux__
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec / 1e9;
+#else
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  return now.tv_sec + now.tv_usec / 1e6;
+#endif
+}
+
+// Events for the watched file, debounced into changes
+struct Burst {
+  bool pending;
+  double first, last;
+
+  Burst() : pending(false), first(0), last(0) {}
+
+  void event() {
+    last = watcherNow();
+    if(!pending) first = last;
+    pending = true;
+  }
+
+  // milliseconds to wait before the burst settles, -1 if there isn't one
+  int timeout(int debounce) {
+    if(!pending) return -1;
+    int left = debounce - (int)((watcherNow() - last) * 1000);
+    return left > 0 ? left : 0;
+  }
+
+  // flag the change once the burst has been quiet long enough
+  void settle(FileWatcher* watcher) {
+    if(!pending || timeout(watcher->debounce) > 0) return;
+    watcher->changedAt = first;
+    __sync_lock_test_and_set(&watcher->changed, 1);
+    pending = false;
+  }
+};
+
+// Without inotify, stat the file on this thread rather than the run
+// loop's. Comparing the inode catches renames over it.
+static void* watchByPolling(void* arg) {
+  FileWatcher* watcher = (FileWatcher*)arg;
+  size_t length = strlen(watcher->directory) + strlen(watcher->name) + 2;
+  char* path = (char*)malloc(length);
+  snprintf(path, length, "%s/%s", watcher->directory, watcher->name);
+
+  struct stat last, now;
+  bool existed = stat(path, &last) == 0;
+  Burst burst;
+
+  while(true) {
+    burst.settle(watcher);
+
+    int timeout = burst.timeout(watcher->debounce);
+    struct pollfd stop = { watcher->stopPipe[0], POLLIN, 0 };
+    if(poll(&stop, 1, timeout < 0 || timeout > FILEWATCHER_POLL_INTERVAL ? FILEWATCHER_POLL_INTERVAL : timeout) > 0) break;
+
+    bool exists = stat(path, &now) == 0;
+    if(exists != existed || (exists && (now.st_mtime != last.st_mtime || now.st_size != last.st_size || now.st_ino != last.st_ino)))
+      burst.event();
+    existed = exists;
+    if(exists) last = now;
+  }
+
+  free(path);
+  return NULL;
+}
+
+#ifdef __linux__
+static void* watchWithInotify(void* arg) {
+  FileWatcher* watcher = (FileWatcher*)arg;
+  int fd = inotify_init();
+  if(fd < 0 || inotify_add_watch(fd, watcher->directory, IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_CREATE | IN_MOVED_TO) < 0) {
+    // out of inotify instances or watches, poll instead
+    if(fd >= 0) close(fd);
+    return watchByPolling(arg);
+  }
+
+  char events[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+  Burst burst;
+
+  while(true) {
+    burst.settle(watcher);
+
+    struct pollfd fds[2] = { { fd, POLLIN, 0 }, { watcher->stopPipe[0], POLLIN, 0 } };
+    int ready = poll(fds, 2, burst.timeout(watcher->debounce));
+    if(ready < 0 && errno != EINTR) break;
+    if(fds[1].revents) break;
+    if(ready <= 0 || !(fds[0].revents & POLLIN)) continue;
+
+    ssize_t length = read(fd, events, sizeof(events));
+    for(char* p = events; length > 0 && p < events + length; ) {
+      struct inotify_event* event = (struct inotify_event*)p;
+      if(event->len && strcmp(event->name, watcher->name) == 0) burst.event();
+      p += sizeof(struct inotify_event) + event->len;
+    }
+  }
+
+  close(fd);
+  return NULL;
+}
+#endif
+
+FileWatcher::FileWatcher() {
+  changed = 0;
+  debounce = 0;
+  changedAt = 0;
+  directory = NULL;
+  name = NULL;
+  running = false;
+}
+
+FileWatcher::~FileWatcher() {
+  stop();
+}
+
+bool FileWatcher::watch(const char* path, int debounceMillis) {
+  stop();
+
+  const char* slash = strrchr(path, '/');
+  directory = slash ? strndup(path, slash == path ? 1 : slash - path) : strdup(".");
+  name = strdup(slash ? slash + 1 : path);
+  debounce = debounceMillis;
+  changed = 0;
+
+  if(pipe(stopPipe) != 0) return false;
+
+#ifdef __linux__
+  running = pthread_create(&thread, NULL, watchWithInotify, this) == 0;
+#else
+  running = pthread_create(&thread, NULL, watchByPolling, this) == 0;
+#endif
+
+  if(!running) {
+    close(stopPipe[0]);
+    close(stopPipe[1]);
+  }
+  return running;
+}
+
+void FileWatcher::stop() {
+  if(running) {
+    if(write(stopPipe[1], "", 1) != 1) pthread_cancel(thread);
+    pthread_join(thread, NULL);
+    close(stopPipe[0]);
+    close(stopPipe[1]);
+    running = false;
+  }
+
+  free(directory);
+  free(name);
+  directory = name = NULL;
+}
+
+bool FileWatcher::takeChange() {
+  return __sync_lock_test_and_set(&changed, 0) != 0;
+}
+
+double FileWatcher::secondsSinceChange() {
+  return watcherNow() - changedAt;
+}
@@ -0,0 +1,42 @@
+#ifndef _FileWatcher_h_header
+#define _FileWatcher_h_header
+
+#include <pthread.h>
+
+// Watches a file for changes from a thread of its own
+//
+// Uses inotify on Linux, watching the file's directory so editors that save
+// by renaming a new file over the old one are caught too. Elsewhere, or if
+// inotify runs out of watches, the thread polls the file's modification
+// time, size and inode. Bursts of events are debounced: changed is set once
+// the file has been quiet for debounce milliseconds. changed is the first
+// field so the run loop can check it straight out of memory, see
+// Zajal::FileWatcher.
+class FileWatcher {
+public:
+  FileWatcher();
+  ~FileWatcher();
+
+  // false if the file couldn't be watched
+  bool watch(const char* path, int debounce);
+  void stop();
+
+  // was the file changed since the last call? clears changed
+  bool takeChange();
+
+  // seconds since the first event of the last change, e.g. to measure how
+  // long a save takes to show up on screen
+  double secondsSinceChange();
+
+  volatile int changed;
+  int debounce;
+  volatile double changedAt;
+
+  char* directory;
+  char* name;
+  int stopPipe[2];
+  bool running;
+  pthread_t thread;
+};
+
+#endif /* _FileWatcher_h_header */
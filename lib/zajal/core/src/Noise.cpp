@@ -0,0 +1,414 @@
+#include "Noise.h"
+#include "Parallel.h"
+
+#include <cstddef>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// jobs smaller than this many samples aren't worth a thread
+#define NOISE_MIN_SAMPLES_PER_JOB 16384
+
+// skew and unskew factors between the simplex and square grids
+#define F2 0.366025403f
+#define G2 0.211324865f
+#define F3 0.333333333f
+#define G3 0.166666667f
+
+// Ken Perlin's permutation, which ofNoise also hashes lattice points with
+static const unsigned char permutation[256] = {
+  151, 160, 137,  91,  90,  15, 131,  13, 201,  95,  96,  53, 194, 233,   7, 225,
+  140,  36, 103,  30,  69, 142,   8,  99,  37, 240,  21,  10,  23, 190,   6, 148,
+  247, 120, 234,  75,   0,  26, 197,  62,  94, 252, 219, 203, 117,  35,  11,  32,
+   57, 177,  33,  88, 237, 149,  56,  87, 174,  20, 125, 136, 171, 168,  68, 175,
+   74, 165,  71, 134, 139,  48,  27, 166,  77, 146, 158, 231,  83, 111, 229, 122,
+   60, 211, 133, 230, 220, 105,  92,  41,  55,  46, 245,  40, 244, 102, 143,  54,
+   65,  25,  63, 161,   1, 216,  80,  73, 209,  76, 132, 187, 208,  89,  18, 169,
+  200, 196, 135, 130, 116, 188, 159,  86, 164, 100, 109, 198, 173, 186,   3,  64,
+   52, 217, 226, 250, 124, 123,   5, 202,  38, 147, 118, 126, 255,  82,  85, 212,
+  207, 206,  59, 227,  47,  16,  58,  17, 182, 189,  28,  42, 223, 183, 170, 213,
+  119, 248, 152,   2,  44, 154, 163,  70, 221, 153, 101, 155, 167,  43, 172,   9,
+  129,  22,  39, 253,  19,  98, 108, 110,  79, 113, 224, 232, 178, 185, 112, 104,
+  218, 246,  97, 228, 251,  34, 242, 193, 238, 210, 144,  12, 191, 179, 162, 241,
+   81,  51, 145, 235, 249,  14, 239, 107,  49, 192, 214,  31, 181, 199, 106, 157,
+  184,  84, 204, 176, 115, 121,  50,  45, 127,   4, 150, 254, 138, 236, 205,  93,
+  222, 114,  67,  29,  24,  72, 243, 141, 128, 195,  78,  66, 215,  61, 156, 180
+};
+
+static inline int hash(int i) {
+  return permutation[i & 255];
+}
+
+static inline int fastFloor(float x) {
+  int i = (int)x;
+  return x < i ? i - 1 : i;
+}
+
+// t^4, or nothing once a point is outside a corner's radius
+static inline float falloff(float t) {
+  t = t < 0.0f ? 0.0f : t;
+  t *= t;
+  return t * t;
+}
+
+/*
+ * scalar simplex noise, one sample at a time
+ */
+
+static inline float grad1(int h, float x) {
+  h &= 15;
+  float g = 1.0f + (h & 7);
+  return (h & 8 ? -g : g) * x;
+}
+
+static inline float grad2(int h, float x, float y) {
+  h &= 7;
+  float u = h < 4 ? x : y;
+  float v = h < 4 ? y : x;
+  return (h & 1 ? -u : u) + (h & 2 ? -2.0f * v : 2.0f * v);
+}
+
+static inline float grad3(int h, float x, float y, float z) {
+  h &= 15;
+  float u = h < 8 ? x : y;
+  float v = h < 4 ? y : (h == 12 || h == 14 ? x : z);
+  return (h & 1 ? -u : u) + (h & 2 ? -v : v);
+}
+
+static float simplex1(float x) {
+  int i = fastFloor(x);
+  float x0 = x - i, x1 = x0 - 1.0f;
+
+  float n0 = falloff(1.0f - x0 * x0) * grad1(hash(i), x0);
+  float n1 = falloff(1.0f - x1 * x1) * grad1(hash(i + 1), x1);
+  return 0.395f * (n0 + n1);
+}
+
+static float simplex2(float x, float y) {
+  float s = (x + y) * F2;
+  int i = fastFloor(x + s), j = fastFloor(y + s);
+  float t = (float)(i + j) * G2;
+  float x0 = x - (i - t), y0 = y - (j - t);
+
+  // which of the two triangles in the skewed cell we're in
+  int i1 = x0 > y0 ? 1 : 0, j1 = 1 - i1;
+
+  float x1 = x0 - i1 + G2, y1 = y0 - j1 + G2;
+  float x2 = x0 - 1.0f + 2.0f * G2, y2 = y0 - 1.0f + 2.0f * G2;
+
+  float n0 = falloff(0.5f - x0 * x0 - y0 * y0) * grad2(hash(i + hash(j)), x0, y0);
+  float n1 = falloff(0.5f - x1 * x1 - y1 * y1) * grad2(hash(i + i1 + hash(j + j1)), x1, y1);
+  float n2 = falloff(0.5f - x2 * x2 - y2 * y2) * grad2(hash(i + 1 + hash(j + 1)), x2, y2);
+  return 40.0f * (n0 + n1 + n2);
+}
+
+static float simplex3(float x, float y, float z) {
+  float s = (x + y + z) * F3;
+  int i = fastFloor(x + s), j = fastFloor(y + s), k = fastFloor(z + s);
+  float t = (float)(i + j + k) * G3;
+  float x0 = x - (i - t), y0 = y - (j - t), z0 = z - (k - t);
+
+  // which of the six tetrahedra in the skewed cell we're in: the second
+  // corner steps along the largest offset, the third along all but the
+  // smallest. Written as comparisons so the SSE2 version can match it.
+  bool xy = x0 >= y0, yz = y0 >= z0, xz = x0 >= z0;
+  int i1 = xy && xz, j1 = !xy && yz, k1 = !i1 && !j1;
+  int i2 = xy || xz, j2 = yz || !xy, k2 = !(yz && xz);
+
+  float x1 = x0 - i1 + G3, y1 = y0 - j1 + G3, z1 = z0 - k1 + G3;
+  float x2 = x0 - i2 + 2.0f * G3, y2 = y0 - j2 + 2.0f * G3, z2 = z0 - k2 + 2.0f * G3;
+  float x3 = x0 - 1.0f + 3.0f * G3, y3 = y0 - 1.0f + 3.0f * G3, z3 = z0 - 1.0f + 3.0f * G3;
+
+  float n0 = falloff(0.6f - x0 * x0 - y0 * y0 - z0 * z0) * grad3(hash(i + hash(j + hash(k))), x0, y0, z0);
+  float n1 = falloff(0.6f - x1 * x1 - y1 * y1 - z1 * z1) * grad3(hash(i + i1 + hash(j + j1 + hash(k + k1))), x1, y1, z1);
+  float n2 = falloff(0.6f - x2 * x2 - y2 * y2 - z2 * z2) * grad3(hash(i + i2 + hash(j + j2 + hash(k + k2))), x2, y2, z2);
+  float n3 = falloff(0.6f - x3 * x3 - y3 * y3 - z3 * z3) * grad3(hash(i + 1 + hash(j + 1 + hash(k + 1))), x3, y3, z3);
+  return 32.0f * (n0 + n1 + n2 + n3);
+}
+
+/*
+ * SSE2 simplex noise, four samples at a time
+ */
+
+#if defined(__SSE2__)
+static inline __m128i floor4(__m128 v) {
+  // truncation rounds negative values up, step those back down
+  __m128i i = _mm_cvttps_epi32(v);
+  return _mm_add_epi32(i, _mm_castps_si128(_mm_cmplt_ps(v, _mm_cvtepi32_ps(i))));
+}
+
+// SSE2 has no gather, so hash each lane separately
+static inline __m128i hash4(__m128i i) {
+  int lanes[4];
+  _mm_storeu_si128((__m128i*)lanes, i);
+  return _mm_setr_epi32(hash(lanes[0]), hash(lanes[1]), hash(lanes[2]), hash(lanes[3]));
+}
+
+static inline __m128 falloff4(__m128 t) {
+  t = _mm_max_ps(t, _mm_setzero_ps());
+  t = _mm_mul_ps(t, t);
+  return _mm_mul_ps(t, t);
+}
+
+static inline __m128 select4(__m128 mask, __m128 a, __m128 b) {
+  return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// lanes of h with bit set
+static inline __m128 hasBit4(__m128i h, int bit) {
+  __m128i b = _mm_set1_epi32(bit);
+  return _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(h, b), b));
+}
+
+static inline __m128 negateWhere4(__m128 mask, __m128 v) {
+  return _mm_xor_ps(v, _mm_and_ps(mask, _mm_set1_ps(-0.0f)));
+}
+
+static inline __m128 dot2(__m128 x, __m128 y) {
+  return _mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y));
+}
+
+static inline __m128 dot3(__m128 x, __m128 y, __m128 z) {
+  return _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+}
+
+static inline __m128 grad2x4(__m128i h, __m128 x, __m128 y) {
+  __m128 low = _mm_castsi128_ps(_mm_cmplt_epi32(_mm_and_si128(h, _mm_set1_epi32(7)), _mm_set1_epi32(4)));
+  __m128 u = select4(low, x, y);
+  __m128 v = select4(low, y, x);
+  return _mm_add_ps(negateWhere4(hasBit4(h, 1), u), negateWhere4(hasBit4(h, 2), _mm_add_ps(v, v)));
+}
+
+static inline __m128 grad3x4(__m128i h, __m128 x, __m128 y, __m128 z) {
+  h = _mm_and_si128(h, _mm_set1_epi32(15));
+  __m128 below8 = _mm_castsi128_ps(_mm_cmplt_epi32(h, _mm_set1_epi32(8)));
+  __m128 below4 = _mm_castsi128_ps(_mm_cmplt_epi32(h, _mm_set1_epi32(4)));
+  __m128 useX = _mm_castsi128_ps(_mm_or_si128(_mm_cmpeq_epi32(h, _mm_set1_epi32(12)), _mm_cmpeq_epi32(h, _mm_set1_epi32(14))));
+  __m128 u = select4(below8, x, y);
+  __m128 v = select4(below4, y, select4(useX, x, z));
+  return _mm_add_ps(negateWhere4(hasBit4(h, 1), u), negateWhere4(hasBit4(h, 2), v));
+}
+
+static __m128 simplex2x4(__m128 x, __m128 y) {
+  __m128 one = _mm_set1_ps(1.0f);
+  __m128 g2 = _mm_set1_ps(G2);
+
+  __m128 s = _mm_mul_ps(_mm_add_ps(x, y), _mm_set1_ps(F2));
+  __m128i i = floor4(_mm_add_ps(x, s)), j = floor4(_mm_add_ps(y, s));
+  __m128 t = _mm_mul_ps(_mm_cvtepi32_ps(_mm_add_epi32(i, j)), g2);
+  __m128 x0 = _mm_sub_ps(x, _mm_sub_ps(_mm_cvtepi32_ps(i), t));
+  __m128 y0 = _mm_sub_ps(y, _mm_sub_ps(_mm_cvtepi32_ps(j), t));
+
+  __m128 first = _mm_cmpgt_ps(x0, y0);
+  __m128 i1 = _mm_and_ps(first, one), j1 = _mm_andnot_ps(first, one);
+
+  __m128 x1 = _mm_add_ps(_mm_sub_ps(x0, i1), g2), y1 = _mm_add_ps(_mm_sub_ps(y0, j1), g2);
+  __m128 last = _mm_set1_ps(2.0f * G2);
+  __m128 x2 = _mm_add_ps(_mm_sub_ps(x0, one), last), y2 = _mm_add_ps(_mm_sub_ps(y0, one), last);
+
+  __m128i one4 = _mm_set1_epi32(1);
+  __m128i h0 = hash4(_mm_add_epi32(i, hash4(j)));
+  __m128i h1 = hash4(_mm_add_epi32(_mm_add_epi32(i, _mm_cvttps_epi32(i1)), hash4(_mm_add_epi32(j, _mm_cvttps_epi32(j1)))));
+  __m128i h2 = hash4(_mm_add_epi32(_mm_add_epi32(i, one4), hash4(_mm_add_epi32(j, one4))));
+
+  __m128 radius = _mm_set1_ps(0.5f);
+  __m128 n0 = _mm_mul_ps(falloff4(_mm_sub_ps(radius, dot2(x0, y0))), grad2x4(h0, x0, y0));
+  __m128 n1 = _mm_mul_ps(falloff4(_mm_sub_ps(radius, dot2(x1, y1))), grad2x4(h1, x1, y1));
+  __m128 n2 = _mm_mul_ps(falloff4(_mm_sub_ps(radius, dot2(x2, y2))), grad2x4(h2, x2, y2));
+  return _mm_mul_ps(_mm_set1_ps(40.0f), _mm_add_ps(_mm_add_ps(n0, n1), n2));
+}
+
+static __m128 simplex3x4(__m128 x, __m128 y, __m128 z) {
+  __m128 one = _mm_set1_ps(1.0f);
+  __m128 g3 = _mm_set1_ps(G3);
+
+  __m128 s = _mm_mul_ps(_mm_add_ps(_mm_add_ps(x, y), z), _mm_set1_ps(F3));
+  __m128i i = floor4(_mm_add_ps(x, s)), j = floor4(_mm_add_ps(y, s)), k = floor4(_mm_add_ps(z, s));
+  __m128 t = _mm_mul_ps(_mm_cvtepi32_ps(_mm_add_epi32(_mm_add_epi32(i, j), k)), g3);
+  __m128 x0 = _mm_sub_ps(x, _mm_sub_ps(_mm_cvtepi32_ps(i), t));
+  __m128 y0 = _mm_sub_ps(y, _mm_sub_ps(_mm_cvtepi32_ps(j), t));
+  __m128 z0 = _mm_sub_ps(z, _mm_sub_ps(_mm_cvtepi32_ps(k), t));
+
+  // same corner choice as simplex3, as masks
+  __m128 xy = _mm_cmpge_ps(x0, y0), yz = _mm_cmpge_ps(y0, z0), xz = _mm_cmpge_ps(x0, z0);
+  __m128 i1m = _mm_and_ps(xy, xz), j1m = _mm_andnot_ps(xy, yz);
+  __m128 i1 = _mm_and_ps(i1m, one), j1 = _mm_and_ps(j1m, one), k1 = _mm_andnot_ps(_mm_or_ps(i1m, j1m), one);
+  __m128 i2 = _mm_and_ps(_mm_or_ps(xy, xz), one);
+  __m128 j2 = _mm_or_ps(_mm_and_ps(yz, one), _mm_andnot_ps(xy, one));
+  __m128 k2 = _mm_andnot_ps(_mm_and_ps(yz, xz), one);
+
+  __m128 x1 = _mm_add_ps(_mm_sub_ps(x0, i1), g3), y1 = _mm_add_ps(_mm_sub_ps(y0, j1), g3), z1 = _mm_add_ps(_mm_sub_ps(z0, k1), g3);
+  __m128 g3x2 = _mm_set1_ps(2.0f * G3);
+  __m128 x2 = _mm_add_ps(_mm_sub_ps(x0, i2), g3x2), y2 = _mm_add_ps(_mm_sub_ps(y0, j2), g3x2), z2 = _mm_add_ps(_mm_sub_ps(z0, k2), g3x2);
+  __m128 g3x3 = _mm_set1_ps(3.0f * G3);
+  __m128 x3 = _mm_add_ps(_mm_sub_ps(x0, one), g3x3), y3 = _mm_add_ps(_mm_sub_ps(y0, one), g3x3), z3 = _mm_add_ps(_mm_sub_ps(z0, one), g3x3);
+
+  __m128i one4 = _mm_set1_epi32(1);
+  __m128i h0 = hash4(_mm_add_epi32(i, hash4(_mm_add_epi32(j, hash4(k)))));
+  __m128i h1 = hash4(_mm_add_epi32(_mm_add_epi32(i, _mm_cvttps_epi32(i1)),
+               hash4(_mm_add_epi32(_mm_add_epi32(j, _mm_cvttps_epi32(j1)),
+               hash4(_mm_add_epi32(k, _mm_cvttps_epi32(k1)))))));
+  __m128i h2 = hash4(_mm_add_epi32(_mm_add_epi32(i, _mm_cvttps_epi32(i2)),
+               hash4(_mm_add_epi32(_mm_add_epi32(j, _mm_cvttps_epi32(j2)),
+               hash4(_mm_add_epi32(k, _mm_cvttps_epi32(k2)))))));
+  __m128i h3 = hash4(_mm_add_epi32(_mm_add_epi32(i, one4),
+               hash4(_mm_add_epi32(_mm_add_epi32(j, one4),
+               hash4(_mm_add_epi32(k, one4))))));
+
+  __m128 radius = _mm_set1_ps(0.6f);
+  __m128 n0 = _mm_mul_ps(falloff4(_mm_sub_ps(radius, dot3(x0, y0, z0))), grad3x4(h0, x0, y0, z0));
+  __m128 n1 = _mm_mul_ps(falloff4(_mm_sub_ps(radius, dot3(x1, y1, z1))), grad3x4(h1, x1, y1, z1));
+  __m128 n2 = _mm_mul_ps(falloff4(_mm_sub_ps(radius, dot3(x2, y2, z2))), grad3x4(h2, x2, y2, z2));
+  __m128 n3 = _mm_mul_ps(falloff4(_mm_sub_ps(radius, dot3(x3, y3, z3))), grad3x4(h3, x3, y3, z3));
+  return _mm_mul_ps(_mm_set1_ps(32.0f), _mm_add_ps(_mm_add_ps(n0, n1), _mm_add_ps(n2, n3)));
+}
+#endif
+
+/*
+ * octaves, ranges and jobs
+ */
+
+struct NoiseJob {
+  float* out;
+  const float* coords;
+  int width, height, components, dimensions, octaves;
+  bool isSigned;
+  float x, y, z, step, time;
+};
+
+static inline float sampleOne(const NoiseJob* job, float x, float y, float z) {
+  float sum = 0.0f, amplitude = 1.0f, total = 0.0f;
+  for(int o = 0; o < job->octaves; o++) {
+    float n = job->dimensions == 1 ? simplex1(x) : (job->dimensions == 2 ? simplex2(x, y) : simplex3(x, y, z));
+    sum += amplitude * n;
+    total += amplitude;
+    amplitude *= 0.5f;
+    x *= 2.0f; y *= 2.0f; z *= 2.0f;
+  }
+
+  sum /= total;
+  return job->isSigned ? sum : sum * 0.5f + 0.5f;
+}
+
+static inline void sampleFour(const NoiseJob* job, const float* xs, const float* ys, const float* zs, float* out) {
+#if defined(__SSE2__)
+  if(job->dimensions > 1) {
+    __m128 x = _mm_loadu_ps(xs), y = _mm_loadu_ps(ys), z = _mm_loadu_ps(zs);
+    __m128 sum = _mm_setzero_ps();
+    float amplitude = 1.0f, total = 0.0f;
+    for(int o = 0; o < job->octaves; o++) {
+      __m128 n = job->dimensions == 2 ? simplex2x4(x, y) : simplex3x4(x, y, z);
+      sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(amplitude), n));
+      total += amplitude;
+      amplitude *= 0.5f;
+      x = _mm_add_ps(x, x); y = _mm_add_ps(y, y); z = _mm_add_ps(z, z);
+    }
+
+    sum = _mm_div_ps(sum, _mm_set1_ps(total));
+    if(!job->isSigned)
+      sum = _mm_add_ps(_mm_mul_ps(sum, _mm_set1_ps(0.5f)), _mm_set1_ps(0.5f));
+    _mm_storeu_ps(out, sum);
+    return;
+  }
+#endif
+  // 1D noise is cheap enough that lanes don't pay for themselves
+  for(int l = 0; l < 4; l++)
+    out[l] = sampleOne(job, xs[l], ys[l], zs[l]);
+}
+
+static void noiseGridRows(void* context, int begin, int end) {
+  NoiseJob* job = (NoiseJob*)context;
+  for(int r = begin; r < end; r++) {
+    float* out = job->out + (size_t)r * job->width;
+    float y = job->y + (r % job->height) * job->step;
+    float z = job->z + (r / job->height) * job->step;
+    float xs[4], ys[4] = { y, y, y, y }, zs[4] = { z, z, z, z };
+
+    int i = 0;
+    for(; i + 4 <= job->width; i += 4) {
+      for(int l = 0; l < 4; l++)
+        xs[l] = job->x + (i + l) * job->step;
+      sampleFour(job, xs, ys, zs, out + i);
+    }
+    for(; i < job->width; i++)
+      out[i] = sampleOne(job, job->x + i * job->step, y, z);
+  }
+}
+
+static inline float coordinate(const NoiseJob* job, int point, int axis) {
+  return axis < job->components ? job->coords[(size_t)point * job->components + axis] : job->time;
+}
+
+static void noisePointRange(void* context, int begin, int end) {
+  NoiseJob* job = (NoiseJob*)context;
+  float xs[4], ys[4], zs[4];
+
+  int i = begin;
+  for(; i + 4 <= end; i += 4) {
+    for(int l = 0; l < 4; l++) {
+      xs[l] = coordinate(job, i + l, 0);
+      ys[l] = coordinate(job, i + l, 1);
+      zs[l] = coordinate(job, i + l, 2);
+    }
+    sampleFour(job, xs, ys, zs, job->out + i);
+  }
+  for(; i < end; i++)
+    job->out[i] = sampleOne(job, coordinate(job, i, 0), coordinate(job, i, 1), coordinate(job, i, 2));
+}
+
+static inline int clampDimensions(int dimensions) {
+  return dimensions < 1 ? 1 : (dimensions > 3 ? 3 : dimensions);
+}
+
+void noiseGrid(float* out, int width, int height, int depth, float x, float y, float z, float step, int dimensions, int octaves, bool isSigned) {
+  if(width <= 0 || height <= 0 || depth <= 0) return;
+
+  NoiseJob job;
+  job.out = out;
+  job.coords = NULL;
+  job.width = width;
+  job.height = height;
+  job.components = 0;
+  job.dimensions = clampDimensions(dimensions);
+  job.octaves = octaves < 1 ? 1 : octaves;
+  job.isSigned = isSigned;
+  job.x = x;
+  job.y = y;
+  job.z = z;
+  job.step = step;
+  job.time = 0.0f;
+
+  parallelBands(height * depth, NOISE_MIN_SAMPLES_PER_JOB / width + 1, noiseGridRows, &job);
+}
+
+void noisePoints(float* out, float* coords, int count, int components, int dimensions, float time, int octaves, bool isSigned) {
+  if(count <= 0) return;
+
+  NoiseJob job;
+  job.out = out;
+  job.coords = coords;
+  job.width = count;
+  job.height = 1;
+  job.components = components;
+  job.dimensions = clampDimensions(dimensions);
+  job.octaves = octaves < 1 ? 1 : octaves;
+  job.isSigned = isSigned;
+  job.x = job.y = job.z = job.step = 0.0f;
+  job.time = time;
+
+  parallelBands(count, NOISE_MIN_SAMPLES_PER_JOB, noisePointRange, &job);
+}
+
+void signedNoise3(float* out, const float* xs, const float* ys, const float* zs, int count) {
+  NoiseJob job;
+  job.dimensions = 3;
+  job.octaves = 1;
+  job.isSigned = true;
+
+  int i = 0;
+  for(; i + 4 <= count; i += 4)
+    sampleFour(&job, xs + i, ys + i, zs + i, out + i);
+  for(; i < count; i++)
+    out[i] = sampleOne(&job, xs[i], ys[i], zs[i]);
+}
@@ -0,0 +1,28 @@
+#ifndef _Noise_h_header
+#define _Noise_h_header
+
+// Bulk simplex noise
+//
+// The same simplex noise ofNoise uses, sampled many points at a time. The
+// 2D and 3D kernels evaluate four points at once with SSE2, and large jobs
+// are split across worker threads (see Parallel.h).
+//
+// Output is in 0..1, or -1..1 when isSigned. With more than one octave,
+// octaves are summed at double the frequency and half the amplitude of the
+// one before, and the sum is normalised back into range.
+
+// Fill out with width*height*depth samples, x fastest then y then z. Sample
+// (i, j, k) is taken at (x + i*step, y + j*step, z + k*step), using the first
+// dimensions (1, 2 or 3) of those coordinates.
+void noiseGrid(float* out, int width, int height, int depth, float x, float y, float z, float step, int dimensions, int octaves, bool isSigned);
+
+// Fill out with count samples taken at coords, which holds count records of
+// components floats. Coordinates past components, up to dimensions, are
+// filled in with time.
+void noisePoints(float* out, float* coords, int count, int components, int dimensions, float time, int octaves, bool isSigned);
+
+// Signed 3D noise at the count points (xs[i], ys[i], zs[i]), on the calling
+// thread, for kernels that already split their work across threads
+void signedNoise3(float* out, const float* xs, const float* ys, const float* zs, int count);
+
+#endif /* _Noise_h_header */
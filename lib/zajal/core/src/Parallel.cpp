@@ -0,0 +1,61 @@
+#include "Parallel.h"
+
+#include <pthread.h>
+#include <unistd.h>
+
+#define PARALLEL_MAX_THREADS 32
+
+struct ParallelBand {
+  ParallelBandFn fn;
+  void* context;
+  int begin, end;
+};
+
+static void* parallelRunBand(void* arg) {
+  ParallelBand* band = (ParallelBand*)arg;
+  band->fn(band->context, band->begin, band->end);
+  return NULL;
+}
+
+int parallelThreadCount() {
+  static int threads = 0;
+  if(threads == 0) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = cores < 1 ? 1 : (cores > PARALLEL_MAX_THREADS ? PARALLEL_MAX_THREADS : cores);
+  }
+
+  return threads;
+}
+
+void parallelBands(int count, int minimum, ParallelBandFn fn, void* context) {
+  int threads = parallelThreadCount();
+  if(count < minimum || count < threads * 2 || threads == 1) {
+    fn(context, 0, count);
+    return;
+  }
+
+  pthread_t workers[PARALLEL_MAX_THREADS];
+  ParallelBand bands[PARALLEL_MAX_THREADS];
+  int bandSize = (count + threads - 1) / threads;
+
+  // the calling thread takes the first band itself
+  int started = 0;
+  for(int i = 1; i < threads; i++) {
+    bands[i].fn = fn;
+    bands[i].context = context;
+    bands[i].begin = i * bandSize;
+    bands[i].end = (i + 1) * bandSize < count ? (i + 1) * bandSize : count;
+    if(bands[i].begin >= bands[i].end) break;
+
+    if(pthread_create(&workers[i], NULL, parallelRunBand, &bands[i]) != 0) {
+      parallelRunBand(&bands[i]);
+      workers[i] = pthread_self();
+    }
+    started = i;
+  }
+
+  fn(context, 0, bandSize < count ? bandSize : count);
+
+  for(int i = 1; i <= started; i++)
+    if(!pthread_equal(workers[i], pthread_self())) pthread_join(workers[i], NULL);
+}
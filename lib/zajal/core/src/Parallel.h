@@ -0,0 +1,15 @@
+#ifndef _Parallel_h_header
+#define _Parallel_h_header
+
+// Split [0, count) into contiguous bands and run fn on each band, one
+// worker thread per core. Falls back to the calling thread when count is
+// below minimum, since thread startup costs more than small jobs.
+// 
+// fn must be safe to run concurrently on disjoint bands.
+typedef void (*ParallelBandFn)(void* context, int begin, int end);
+
+void parallelBands(int count, int minimum, ParallelBandFn fn, void* context);
+
+int parallelThreadCount();
+
+#endif /* _Parallel_h_header */
@@ -0,0 +1,349 @@
+#include "ParticleSystem.h"
+#include "Parallel.h"
+#include "Noise.h"
+
+#include <cfloat>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// particles are processed in chunks this big, so per chunk scratch fits on
+// the stack
+#define PARTICLE_CHUNK 256
+
+// bands smaller than this many particles aren't worth a thread
+#define PARTICLE_MIN_PER_JOB 4096
+
+// offsets between the noise fields that push along x and along y, so the
+// two don't move in lockstep
+#define PARTICLE_NOISE_OFFSET_X 31.416f
+#define PARTICLE_NOISE_OFFSET_Y 47.853f
+
+ParticleSystem::ParticleSystem() {
+  count = 0;
+  capacity = 0;
+  stepTime = stepLength = 0.0f;
+  drawMode = 0;
+  drawSize = 1.0f;
+  drawFade = false;
+  seed = 2463534242u;
+}
+
+void ParticleSystem::setup(int newCapacity) {
+  capacity = newCapacity < 0 ? 0 : newCapacity;
+  count = 0;
+
+  vector<float>* attributes[] = { &x, &y, &vx, &vy, &age, &life, &r, &g, &b, &a };
+  for(int i = 0; i < 10; i++)
+    attributes[i]->resize(capacity);
+}
+
+int ParticleSystem::emit(float* records, int emitted) {
+  if(emitted > capacity - count) emitted = capacity - count;
+
+  for(int i = 0; i < emitted; i++, records += 9) {
+    int p = count + i;
+    x[p] = records[0];
+    y[p] = records[1];
+    vx[p] = records[2];
+    vy[p] = records[3];
+    age[p] = 0.0f;
+    life[p] = records[4];
+    r[p] = records[5];
+    g[p] = records[6];
+    b[p] = records[7];
+    a[p] = records[8];
+  }
+
+  count += emitted;
+  return emitted;
+}
+
+// xorshift, plenty for scattering particles
+static inline float randomUnit(unsigned int& seed) {
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+  return (seed >> 8) * (1.0f / 16777216.0f);
+}
+
+int ParticleSystem::burst(int emitted, float bx, float by, float speed, float blife, float br, float bg, float bb, float ba) {
+  if(emitted > capacity - count) emitted = capacity - count;
+
+  for(int i = 0; i < emitted; i++) {
+    int p = count + i;
+    float angle = randomUnit(seed) * TWO_PI;
+    float s = randomUnit(seed) * speed;
+    x[p] = bx;
+    y[p] = by;
+    vx[p] = cosf(angle) * s;
+    vy[p] = sinf(angle) * s;
+    age[p] = 0.0f;
+    life[p] = blife;
+    r[p] = br;
+    g[p] = bg;
+    b[p] = bb;
+    a[p] = ba;
+  }
+
+  count += emitted;
+  return emitted;
+}
+
+int ParticleSystem::addForce(int kind, float fa, float fb, float fc, float fd) {
+  ParticleForce force = { kind, fa, fb, fc, fd };
+  forces.push_back(force);
+  return forces.size() - 1;
+}
+
+void ParticleSystem::setForce(int index, float fa, float fb, float fc, float fd) {
+  if(index < 0 || index >= (int)forces.size()) return;
+
+  forces[index].a = fa;
+  forces[index].b = fb;
+  forces[index].c = fc;
+  forces[index].d = fd;
+}
+
+void ParticleSystem::clearForces() {
+  forces.clear();
+}
+
+/*
+ * update
+ */
+
+static inline void addConstant(float* out, float k, int n) {
+  for(int i = 0; i < n; i++)
+    out[i] += k;
+}
+
+// out[i] += k * in[i]
+static inline void addScaled(float* out, const float* in, float k, int n) {
+  int i = 0;
+#if defined(__SSE2__)
+  __m128 k4 = _mm_set1_ps(k);
+  for(; i + 4 <= n; i += 4)
+    _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(k4, _mm_loadu_ps(in + i))));
+#endif
+  for(; i < n; i++)
+    out[i] += k * in[i];
+}
+
+// inverse square pull, with distances under 1 treated as 1 so particles
+// passing through the center don't shoot off
+static void attract(float* ax, float* ay, const float* px, const float* py, int n, const ParticleForce& force) {
+  float radius2 = force.d > 0.0f ? force.d * force.d : FLT_MAX;
+
+  int i = 0;
+#if defined(__SSE2__)
+  __m128 cx = _mm_set1_ps(force.a), cy = _mm_set1_ps(force.b);
+  __m128 strength = _mm_set1_ps(force.c), within = _mm_set1_ps(radius2), one = _mm_set1_ps(1.0f);
+  for(; i + 4 <= n; i += 4) {
+    __m128 dx = _mm_sub_ps(cx, _mm_loadu_ps(px + i));
+    __m128 dy = _mm_sub_ps(cy, _mm_loadu_ps(py + i));
+    __m128 d2 = _mm_max_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), one);
+    __m128 k = _mm_div_ps(strength, _mm_mul_ps(d2, _mm_sqrt_ps(d2)));
+    k = _mm_and_ps(k, _mm_cmple_ps(d2, within));
+    _mm_storeu_ps(ax + i, _mm_add_ps(_mm_loadu_ps(ax + i), _mm_mul_ps(dx, k)));
+    _mm_storeu_ps(ay + i, _mm_add_ps(_mm_loadu_ps(ay + i), _mm_mul_ps(dy, k)));
+  }
+#endif
+  for(; i < n; i++) {
+    float dx = force.a - px[i], dy = force.b - py[i];
+    float d2 = dx * dx + dy * dy;
+    d2 = d2 < 1.0f ? 1.0f : d2;
+    if(d2 > radius2) continue;
+
+    float k = force.c / (d2 * sqrtf(d2));
+    ax[i] += dx * k;
+    ay[i] += dy * k;
+  }
+}
+
+static void pushAlongNoise(float* ax, float* ay, const float* px, const float* py, int n, const ParticleForce& force, float time) {
+  float nx[PARTICLE_CHUNK], ny[PARTICLE_CHUNK], nz[PARTICLE_CHUNK], noise[PARTICLE_CHUNK];
+  for(int i = 0; i < n; i++) {
+    nx[i] = px[i] * force.a;
+    ny[i] = py[i] * force.a;
+    nz[i] = time * force.c;
+  }
+  signedNoise3(noise, nx, ny, nz, n);
+  addScaled(ax, noise, force.b, n);
+
+  for(int i = 0; i < n; i++) {
+    nx[i] += PARTICLE_NOISE_OFFSET_X;
+    ny[i] += PARTICLE_NOISE_OFFSET_Y;
+  }
+  signedNoise3(noise, nx, ny, nz, n);
+  addScaled(ay, noise, force.b, n);
+}
+
+// semi-implicit Euler: velocity first, then position with the new velocity
+static void integrate(float* px, float* py, float* pvx, float* pvy, float* page, const float* ax, const float* ay, int n, float dt, float damping) {
+  int i = 0;
+#if defined(__SSE2__)
+  __m128 dt4 = _mm_set1_ps(dt), damping4 = _mm_set1_ps(damping);
+  for(; i + 4 <= n; i += 4) {
+    __m128 vx4 = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(pvx + i), _mm_mul_ps(_mm_loadu_ps(ax + i), dt4)), damping4);
+    __m128 vy4 = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(pvy + i), _mm_mul_ps(_mm_loadu_ps(ay + i), dt4)), damping4);
+    _mm_storeu_ps(pvx + i, vx4);
+    _mm_storeu_ps(pvy + i, vy4);
+    _mm_storeu_ps(px + i, _mm_add_ps(_mm_loadu_ps(px + i), _mm_mul_ps(vx4, dt4)));
+    _mm_storeu_ps(py + i, _mm_add_ps(_mm_loadu_ps(py + i), _mm_mul_ps(vy4, dt4)));
+    _mm_storeu_ps(page + i, _mm_add_ps(_mm_loadu_ps(page + i), dt4));
+  }
+#endif
+  for(; i < n; i++) {
+    pvx[i] = (pvx[i] + ax[i] * dt) * damping;
+    pvy[i] = (pvy[i] + ay[i] * dt) * damping;
+    px[i] += pvx[i] * dt;
+    py[i] += pvy[i] * dt;
+    page[i] += dt;
+  }
+}
+
+static void updateBand(void* context, int begin, int end) {
+  ParticleSystem* system = (ParticleSystem*)context;
+  float dt = system->stepLength;
+  float ax[PARTICLE_CHUNK], ay[PARTICLE_CHUNK];
+
+  float drag = 0.0f;
+  for(size_t f = 0; f < system->forces.size(); f++)
+    if(system->forces[f].kind == PARTICLE_DRAG) drag += system->forces[f].a;
+  float damping = 1.0f - drag * dt;
+  damping = damping < 0.0f ? 0.0f : damping;
+
+  for(int start = begin; start < end; start += PARTICLE_CHUNK) {
+    int n = end - start < PARTICLE_CHUNK ? end - start : PARTICLE_CHUNK;
+    float* px = &system->x[start];
+    float* py = &system->y[start];
+
+    for(int i = 0; i < n; i++)
+      ax[i] = ay[i] = 0.0f;
+
+    for(size_t f = 0; f < system->forces.size(); f++) {
+      const ParticleForce& force = system->forces[f];
+      switch(force.kind) {
+        case PARTICLE_GRAVITY:
+          addConstant(ax, force.a, n);
+          addConstant(ay, force.b, n);
+          break;
+        case PARTICLE_ATTRACTOR:
+          attract(ax, ay, px, py, n, force);
+          break;
+        case PARTICLE_NOISE:
+          pushAlongNoise(ax, ay, px, py, n, force, system->stepTime);
+          break;
+      }
+    }
+
+    integrate(px, py, &system->vx[start], &system->vy[start], &system->age[start], ax, ay, n, dt, damping);
+  }
+}
+
+void ParticleSystem::update(float dt, float time) {
+  stepLength = dt;
+  stepTime = time;
+  if(count > 0)
+    parallelBands(count, PARTICLE_MIN_PER_JOB, updateBand, this);
+
+  // expire particles by moving the last one into their place
+  vector<float>* attributes[] = { &x, &y, &vx, &vy, &age, &life, &r, &g, &b, &a };
+  for(int i = 0; i < count; ) {
+    if(life[i] > 0.0f && age[i] >= life[i]) {
+      count--;
+      for(int k = 0; k < 10; k++)
+        (*attributes[k])[i] = (*attributes[k])[count];
+    } else {
+      i++;
+    }
+  }
+}
+
+/*
+ * draw
+ */
+
+static void buildBand(void* context, int begin, int end) {
+  ParticleSystem* system = (ParticleSystem*)context;
+  int corners = system->drawMode == 0 ? 1 : 6;
+  float half = system->drawSize * 0.5f;
+
+  for(int i = begin; i < end; i++) {
+    float alpha = system->a[i];
+    if(system->drawFade && system->life[i] > 0.0f)
+      alpha *= 1.0f - system->age[i] / system->life[i];
+
+    float* v = &system->vertices[i * corners * 2];
+    float* c = &system->colors[i * corners * 4];
+    if(corners == 1) {
+      v[0] = system->x[i];
+      v[1] = system->y[i];
+    } else {
+      // two triangles per quad
+      float x0 = system->x[i] - half, y0 = system->y[i] - half;
+      float x1 = system->x[i] + half, y1 = system->y[i] + half;
+      float quad[12] = { x0, y0,  x1, y0,  x1, y1,  x0, y0,  x1, y1,  x0, y1 };
+      for(int k = 0; k < 12; k++)
+        v[k] = quad[k];
+    }
+
+    for(int k = 0; k < corners; k++, c += 4) {
+      c[0] = system->r[i];
+      c[1] = system->g[i];
+      c[2] = system->b[i];
+      c[3] = alpha;
+    }
+  }
+}
+
+void ParticleSystem::draw(int mode, float size, bool fade) {
+  if(count == 0) return;
+
+  drawMode = mode == 0 ? 0 : 1;
+  drawSize = size;
+  drawFade = fade;
+
+  int corners = drawMode == 0 ? 1 : 6;
+  vertices.resize(count * corners * 2);
+  colors.resize(count * corners * 4);
+  parallelBands(count, PARTICLE_MIN_PER_JOB, buildBand, this);
+
+  if(drawMode == 0) glPointSize(size);
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glEnableClientState(GL_COLOR_ARRAY);
+  glVertexPointer(2, GL_FLOAT, 0, &vertices[0]);
+  glColorPointer(4, GL_FLOAT, 0, &colors[0]);
+  glDrawArrays(drawMode == 0 ? GL_POINTS : GL_TRIANGLES, 0, count * corners);
+  glDisableClientState(GL_COLOR_ARRAY);
+  glDisableClientState(GL_VERTEX_ARRAY);
+
+  // drawing with a color array leaves the current color undefined
+  ofSetColor(ofGetStyle().color);
+}
+
+void ParticleSystem::copyPositions(float* out) {
+  for(int i = 0; i < count; i++) {
+    out[i * 2] = x[i];
+    out[i * 2 + 1] = y[i];
+  }
+}
+
+float* ParticleSystem::getX() {
+  return x.empty() ? NULL : &x[0];
+}
+
+float* ParticleSystem::getY() {
+  return y.empty() ? NULL : &y[0];
+}
+
+int ParticleSystem::getCount() {
+  return count;
+}
+
+void ParticleSystem::clear() {
+  count = 0;
+}
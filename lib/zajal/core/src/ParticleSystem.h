@@ -0,0 +1,83 @@
+#ifndef _ParticleSystem_h_header
+#define _ParticleSystem_h_header
+
+#include "ofMain.h"
+
+// Forces a ParticleSystem can apply, and what their parameters mean
+enum ParticleForceKind {
+  PARTICLE_GRAVITY,   // constant acceleration (a, b)
+  PARTICLE_DRAG,      // lose a times velocity per second
+  PARTICLE_ATTRACTOR, // pull toward (a, b) with strength c, only within radius d
+                      // when d > 0. Negative strength pushes away.
+  PARTICLE_NOISE      // push along a noise field of scale a and strength b,
+                      // which changes at speed c
+};
+
+struct ParticleForce {
+  int kind;
+  float a, b, c, d;
+};
+
+// Many simple 2D particles, one array per attribute
+//
+// update() applies every force and moves every particle, four at a time
+// with SSE2 and in bands across worker threads (see Parallel.h), then
+// removes particles older than their life. draw() renders every particle
+// with a single draw call, as points or as square quads.
+class ParticleSystem {
+public:
+  ParticleSystem();
+
+  // Make room for capacity particles, removing any that are alive
+  void setup(int capacity);
+
+  // records holds count records of 9 floats: x, y, vx, vy, life, r, g, b, a.
+  // A life of 0 never expires, colors are 0..1. Particles past capacity are
+  // dropped. Returns how many were emitted.
+  int emit(float* records, int count);
+
+  // Emit count particles at (x, y) flying in random directions at up to
+  // speed. Returns how many were emitted.
+  int burst(int count, float x, float y, float speed, float life, float r, float g, float b, float a);
+
+  // Returns the force's index, for setForce
+  int addForce(int kind, float a, float b, float c, float d);
+  void setForce(int index, float a, float b, float c, float d);
+  void clearForces();
+
+  // Advance dt seconds. time drives noise forces.
+  void update(float dt, float time);
+
+  // mode 0 draws points size pixels across, mode 1 draws size*size quads.
+  // With fade, alpha falls to nothing over each particle's life.
+  void draw(int mode, float size, bool fade);
+
+  // Write count x, y pairs into out
+  void copyPositions(float* out);
+
+  // The x and y arrays themselves, for reading in place. They move when
+  // setup() is called.
+  float* getX();
+  float* getY();
+
+  int getCount();
+  void clear();
+
+  int count;
+  int capacity;
+  vector<float> x, y, vx, vy, age, life, r, g, b, a;
+  vector<ParticleForce> forces;
+
+  // vertex and color arrays for draw, kept between frames
+  vector<float> vertices, colors;
+
+  // state of the update or draw in progress, shared with worker threads
+  float stepTime, stepLength;
+  int drawMode;
+  float drawSize;
+  bool drawFade;
+
+  unsigned int seed;
+};
+
+#endif /* _ParticleSystem_h_header */
@@ -0,0 +1,456 @@
+#include "PixelKernels.h"
+#include "Parallel.h"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// bands smaller than this many pixels aren't worth a thread
+#define KERNEL_MIN_PIXELS_PER_JOB (256 * 256)
+
+static int minimumRows(int width) {
+  return KERNEL_MIN_PIXELS_PER_JOB / (width > 0 ? width : 1);
+}
+
+static inline int clampIndex(int i, int size) {
+  return i < 0 ? 0 : (i >= size ? size - 1 : i);
+}
+
+// out[i] += k * in[i]
+static inline void multiplyAdd(float* out, const float* in, float k, int n) {
+  int i = 0;
+#if defined(__AVX2__)
+  __m256 k8 = _mm256_set1_ps(k);
+  for(; i + 8 <= n; i += 8)
+    _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(out + i), _mm256_mul_ps(k8, _mm256_loadu_ps(in + i))));
+#elif defined(__SSE2__)
+  __m128 k4 = _mm_set1_ps(k);
+  for(; i + 4 <= n; i += 4)
+    _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(k4, _mm_loadu_ps(in + i))));
+#endif
+  for(; i < n; i++)
+    out[i] += k * in[i];
+}
+
+// round and saturate floats back down to bytes
+static inline void storeBytes(unsigned char* out, const float* in, int n) {
+  int i = 0;
+#if defined(__SSE2__)
+  for(; i + 4 <= n; i += 4) {
+    __m128i v = _mm_cvtps_epi32(_mm_loadu_ps(in + i));
+    v = _mm_packs_epi32(v, v);
+    v = _mm_packus_epi16(v, v);
+    int packed = _mm_cvtsi128_si32(v);
+    memcpy(out + i, &packed, 4);
+  }
+#endif
+  for(; i < n; i++) {
+    float v = in[i] + 0.5f;
+    out[i] = v <= 0.0f ? 0 : (v >= 255.0f ? 255 : (unsigned char)v);
+  }
+}
+
+// copy a row into floats with radius pixels of its edges repeated either side
+static inline void loadPaddedRow(float* out, const unsigned char* row, int width, int channels, int radius) {
+  for(int x = -radius; x < width + radius; x++) {
+    const unsigned char* p = row + clampIndex(x, width) * channels;
+    for(int c = 0; c < channels; c++)
+      *out++ = p[c];
+  }
+}
+
+/*
+ * separable convolution
+ */
+
+struct SeparableJob {
+  unsigned char* pixels;
+  float* scratch;
+  const float* kernel;
+  int width, height, channels, radius;
+};
+
+static void separableHorizontal(void* context, int begin, int end) {
+  SeparableJob* job = (SeparableJob*)context;
+  int rowSize = job->width * job->channels;
+  vector<float> padded((job->width + 2 * job->radius) * job->channels);
+
+  for(int y = begin; y < end; y++) {
+    loadPaddedRow(&padded[0], job->pixels + y * rowSize, job->width, job->channels, job->radius);
+
+    float* out = job->scratch + y * rowSize;
+    memset(out, 0, rowSize * sizeof(float));
+    for(int k = 0; k <= 2 * job->radius; k++)
+      multiplyAdd(out, &padded[k * job->channels], job->kernel[k], rowSize);
+  }
+}
+
+static void separableVertical(void* context, int begin, int end) {
+  SeparableJob* job = (SeparableJob*)context;
+  int rowSize = job->width * job->channels;
+  vector<float> sum(rowSize);
+
+  for(int y = begin; y < end; y++) {
+    memset(&sum[0], 0, rowSize * sizeof(float));
+    for(int k = 0; k <= 2 * job->radius; k++)
+      multiplyAdd(&sum[0], job->scratch + clampIndex(y + k - job->radius, job->height) * rowSize, job->kernel[k], rowSize);
+
+    storeBytes(job->pixels + y * rowSize, &sum[0], rowSize);
+  }
+}
+
+static void separableConvolve(ofPixels& pixels, vector<float>& scratch, const vector<float>& kernel) {
+  SeparableJob job;
+  job.pixels = pixels.getPixels();
+  job.width = pixels.getWidth();
+  job.height = pixels.getHeight();
+  job.channels = pixels.getNumChannels();
+  job.radius = kernel.size() / 2;
+  job.kernel = &kernel[0];
+
+  scratch.resize(job.width * job.height * job.channels);
+  job.scratch = &scratch[0];
+
+  parallelBands(job.height, minimumRows(job.width), separableHorizontal, &job);
+  parallelBands(job.height, minimumRows(job.width), separableVertical, &job);
+}
+
+/*
+ * 2D convolution
+ */
+
+struct ConvolveJob {
+  unsigned char* pixels;
+  float* padded;
+  const float* kernel;
+  int width, height, channels, size;
+};
+
+static void convolvePad(void* context, int begin, int end) {
+  ConvolveJob* job = (ConvolveJob*)context;
+  int radius = job->size / 2;
+  int paddedSize = (job->width + 2 * radius) * job->channels;
+
+  for(int y = begin; y < end; y++)
+    loadPaddedRow(job->padded + y * paddedSize, job->pixels + y * job->width * job->channels, job->width, job->channels, radius);
+}
+
+static void convolveRows(void* context, int begin, int end) {
+  ConvolveJob* job = (ConvolveJob*)context;
+  int radius = job->size / 2;
+  int rowSize = job->width * job->channels;
+  int paddedSize = (job->width + 2 * radius) * job->channels;
+  vector<float> sum(rowSize);
+
+  for(int y = begin; y < end; y++) {
+    memset(&sum[0], 0, rowSize * sizeof(float));
+
+    for(int ky = 0; ky < job->size; ky++) {
+      const float* row = job->padded + clampIndex(y + ky - radius, job->height) * paddedSize;
+      for(int kx = 0; kx < job->size; kx++)
+        multiplyAdd(&sum[0], row + kx * job->channels, job->kernel[ky * job->size + kx], rowSize);
+    }
+
+    unsigned char* out = job->pixels + y * rowSize;
+    storeBytes(out, &sum[0], rowSize);
+
+    if(job->channels == 4) {
+      const float* original = job->padded + y * paddedSize + radius * 4;
+      for(int x = 0; x < job->width; x++)
+        out[x * 4 + 3] = (unsigned char)original[x * 4 + 3];
+    }
+  }
+}
+
+/*
+ * per pixel kernels
+ */
+
+struct PointJob {
+  unsigned char* pixels;
+  int width, channels, level;
+};
+
+static void grayscaleRows(void* context, int begin, int end) {
+  PointJob* job = (PointJob*)context;
+  int c = job->channels;
+  int x = 0, n = (end - begin) * job->width;
+  unsigned char* p = job->pixels + begin * job->width * c;
+
+#if defined(__SSE2__)
+  if(c == 4) {
+    __m128i low = _mm_set1_epi32(0xff);
+    __m128i alpha = _mm_set1_epi32(0xff000000);
+    for(; x + 4 <= n; x += 4, p += 16) {
+      __m128i v = _mm_loadu_si128((__m128i*)p);
+      __m128i r = _mm_and_si128(v, low);
+      __m128i g = _mm_and_si128(_mm_srli_epi32(v, 8), low);
+      __m128i b = _mm_and_si128(_mm_srli_epi32(v, 16), low);
+
+      // weights sum to 256 so the luma fits in the low 16 bits of each lane
+      __m128i l = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi32(77)), _mm_mullo_epi16(g, _mm_set1_epi32(150))), _mm_mullo_epi16(b, _mm_set1_epi32(29)));
+      l = _mm_srli_epi32(l, 8);
+
+      __m128i gray = _mm_or_si128(_mm_or_si128(l, _mm_slli_epi32(l, 8)), _mm_slli_epi32(l, 16));
+      _mm_storeu_si128((__m128i*)p, _mm_or_si128(gray, _mm_and_si128(v, alpha)));
+    }
+  }
+#endif
+
+  if(c < 3) return;
+  for(; x < n; x++, p += c)
+    p[0] = p[1] = p[2] = (p[0] * 77 + p[1] * 150 + p[2] * 29) >> 8;
+}
+
+static void thresholdRows(void* context, int begin, int end) {
+  PointJob* job = (PointJob*)context;
+  int c = job->channels;
+  int i = 0, n = (end - begin) * job->width * c;
+  unsigned char* p = job->pixels + begin * job->width * c;
+
+  // unsigned compare by flipping the sign bit of both sides
+#if defined(__AVX2__)
+  if(c == 1 || c == 4) {
+    __m256i bias = _mm256_set1_epi8((char)0x80);
+    __m256i level = _mm256_set1_epi8((char)(job->level ^ 0x80));
+    __m256i alpha = c == 4 ? _mm256_set1_epi32(0xff000000) : _mm256_setzero_si256();
+    for(; i + 32 <= n; i += 32) {
+      __m256i v = _mm256_loadu_si256((__m256i*)(p + i));
+      __m256i above = _mm256_cmpgt_epi8(_mm256_xor_si256(v, bias), level);
+      _mm256_storeu_si256((__m256i*)(p + i), _mm256_or_si256(_mm256_andnot_si256(alpha, above), _mm256_and_si256(alpha, v)));
+    }
+  }
+#elif defined(__SSE2__)
+  if(c == 1 || c == 4) {
+    __m128i bias = _mm_set1_epi8((char)0x80);
+    __m128i level = _mm_set1_epi8((char)(job->level ^ 0x80));
+    __m128i alpha = c == 4 ? _mm_set1_epi32(0xff000000) : _mm_setzero_si128();
+    for(; i + 16 <= n; i += 16) {
+      __m128i v = _mm_loadu_si128((__m128i*)(p + i));
+      __m128i above = _mm_cmpgt_epi8(_mm_xor_si128(v, bias), level);
+      _mm_storeu_si128((__m128i*)(p + i), _mm_or_si128(_mm_andnot_si128(alpha, above), _mm_and_si128(alpha, v)));
+    }
+  }
+#endif
+
+  for(; i < n; i++)
+    if(c != 4 || i % 4 != 3) p[i] = p[i] > job->level ? 255 : 0;
+}
+
+static void premultiplyRows(void* context, int begin, int end) {
+  PointJob* job = (PointJob*)context;
+  int x = 0, n = (end - begin) * job->width;
+  unsigned char* p = job->pixels + begin * job->width * 4;
+
+#if defined(__SSE2__)
+  __m128i zero = _mm_setzero_si128();
+  __m128i round = _mm_set1_epi16(128);
+  __m128i alphaMask = _mm_set1_epi32(0xff000000);
+  for(; x + 4 <= n; x += 4, p += 16) {
+    __m128i v = _mm_loadu_si128((__m128i*)p);
+    __m128i halves[2] = { _mm_unpacklo_epi8(v, zero), _mm_unpackhi_epi8(v, zero) };
+
+    for(int h = 0; h < 2; h++) {
+      __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(halves[h], _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+      // exact x*a/255: t = x*a + 128, (t + (t >> 8)) >> 8
+      __m128i t = _mm_add_epi16(_mm_mullo_epi16(halves[h], a), round);
+      halves[h] = _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+    }
+
+    __m128i color = _mm_packus_epi16(halves[0], halves[1]);
+    _mm_storeu_si128((__m128i*)p, _mm_or_si128(_mm_andnot_si128(alphaMask, color), _mm_and_si128(alphaMask, v)));
+  }
+#endif
+
+  for(; x < n; x++, p += 4)
+    for(int c = 0; c < 3; c++) {
+      int t = p[c] * p[3] + 128;
+      p[c] = (t + (t >> 8)) >> 8;
+    }
+}
+
+/*
+ * resampling
+ */
+
+// Filter taps for resampling `from` samples down (or up) to `to`. Each
+// output sample i reads taps weights starting at source sample start[i].
+struct ResampleTable {
+  int taps;
+  vector<int> start;
+  vector<float> weights;
+
+  ResampleTable(int from, int to) {
+    float scale = (float)from / to;
+    float support = scale > 1.0f ? scale : 1.0f;
+    taps = (int)ceil(support * 2.0f) + 1;
+    start.resize(to);
+    weights.assign(to * taps, 0.0f);
+
+    for(int i = 0; i < to; i++) {
+      float center = (i + 0.5f) * scale - 0.5f;
+      int first = (int)floor(center - support) + 1;
+      float total = 0.0f;
+
+      start[i] = first;
+      for(int t = 0; t < taps; t++) {
+        float w = 1.0f - fabs(first + t - center) / support;
+        weights[i * taps + t] = w > 0.0f ? w : 0.0f;
+        total += weights[i * taps + t];
+      }
+      for(int t = 0; t < taps; t++)
+        weights[i * taps + t] /= total;
+    }
+  }
+};
+
+struct ResizeJob {
+  const unsigned char* source;
+  unsigned char* destination;
+  float* scratch;
+  const ResampleTable* columns;
+  const ResampleTable* rows;
+  int sourceWidth, sourceHeight, width, channels;
+};
+
+static void resizeHorizontal(void* context, int begin, int end) {
+  ResizeJob* job = (ResizeJob*)context;
+  int c = job->channels;
+  const ResampleTable& table = *job->columns;
+
+  for(int y = begin; y < end; y++) {
+    const unsigned char* row = job->source + y * job->sourceWidth * c;
+    float* out = job->scratch + y * job->width * c;
+
+    for(int x = 0; x < job->width; x++, out += c) {
+      const float* w = &table.weights[x * table.taps];
+      for(int ch = 0; ch < c; ch++) out[ch] = 0.0f;
+
+      for(int t = 0; t < table.taps; t++) {
+        const unsigned char* p = row + clampIndex(table.start[x] + t, job->sourceWidth) * c;
+        for(int ch = 0; ch < c; ch++)
+          out[ch] += w[t] * p[ch];
+      }
+    }
+  }
+}
+
+static void resizeVertical(void* context, int begin, int end) {
+  ResizeJob* job = (ResizeJob*)context;
+  const ResampleTable& table = *job->rows;
+  int rowSize = job->width * job->channels;
+  vector<float> sum(rowSize);
+
+  for(int y = begin; y < end; y++) {
+    memset(&sum[0], 0, rowSize * sizeof(float));
+    for(int t = 0; t < table.taps; t++)
+      multiplyAdd(&sum[0], job->scratch + clampIndex(table.start[y] + t, job->sourceHeight) * rowSize, table.weights[y * table.taps + t], rowSize);
+
+    storeBytes(job->destination + y * rowSize, &sum[0], rowSize);
+  }
+}
+
+/*
+ * PixelKernels
+ */
+
+PixelKernels::PixelKernels() {}
+
+// unallocated or zero-size pixels have nothing to process, and the kernels
+// would index into empty buffers
+static bool isEmpty(ofPixels& pixels) {
+  return pixels.getWidth() < 1 || pixels.getHeight() < 1;
+}
+
+void PixelKernels::boxBlur(ofPixels& pixels, int radius) {
+  if(radius < 1 || isEmpty(pixels)) return;
+
+  vector<float> kernel(radius * 2 + 1, 1.0f / (radius * 2 + 1));
+  separableConvolve(pixels, scratch, kernel);
+}
+
+void PixelKernels::gaussianBlur(ofPixels& pixels, float sigma) {
+  if(sigma <= 0.0f || isEmpty(pixels)) return;
+
+  int radius = (int)ceil(sigma * 3.0f);
+  vector<float> kernel(radius * 2 + 1);
+  float total = 0.0f;
+  for(int i = -radius; i <= radius; i++)
+    total += kernel[i + radius] = exp(-(i * i) / (2.0f * sigma * sigma));
+  for(size_t i = 0; i < kernel.size(); i++)
+    kernel[i] /= total;
+
+  separableConvolve(pixels, scratch, kernel);
+}
+
+void PixelKernels::convolve(ofPixels& pixels, float* kernel, int size) {
+  if(size < 1 || size % 2 == 0 || isEmpty(pixels)) return;
+
+  ConvolveJob job;
+  job.pixels = pixels.getPixels();
+  job.kernel = kernel;
+  job.size = size;
+  job.width = pixels.getWidth();
+  job.height = pixels.getHeight();
+  job.channels = pixels.getNumChannels();
+
+  scratch.resize((job.width + size - 1) * job.height * job.channels);
+  job.padded = &scratch[0];
+
+  parallelBands(job.height, minimumRows(job.width), convolvePad, &job);
+  parallelBands(job.height, minimumRows(job.width), convolveRows, &job);
+}
+
+void PixelKernels::grayscale(ofPixels& pixels) {
+  if(isEmpty(pixels)) return;
+
+  PointJob job = { pixels.getPixels(), pixels.getWidth(), pixels.getNumChannels(), 0 };
+  parallelBands(pixels.getHeight(), minimumRows(job.width), grayscaleRows, &job);
+}
+
+void PixelKernels::threshold(ofPixels& pixels, int level) {
+  if(isEmpty(pixels)) return;
+
+  PointJob job = { pixels.getPixels(), pixels.getWidth(), pixels.getNumChannels(), clampIndex(level, 256) };
+  parallelBands(pixels.getHeight(), minimumRows(job.width), thresholdRows, &job);
+}
+
+void PixelKernels::premultiply(ofPixels& pixels) {
+  if(pixels.getNumChannels() != 4 || isEmpty(pixels)) return;
+
+  PointJob job = { pixels.getPixels(), pixels.getWidth(), 4, 0 };
+  parallelBands(pixels.getHeight(), minimumRows(job.width), premultiplyRows, &job);
+}
+
+void PixelKernels::resize(ofPixels& pixels, int width, int height) {
+  if(width < 1 || height < 1 || isEmpty(pixels)) return;
+
+  ResampleTable columns(pixels.getWidth(), width);
+  ResampleTable rows(pixels.getHeight(), height);
+
+  ofPixels resized;
+  resized.allocate(width, height, pixels.getNumChannels());
+
+  ResizeJob job;
+  job.source = pixels.getPixels();
+  job.destination = resized.getPixels();
+  job.columns = &columns;
+  job.rows = &rows;
+  job.sourceWidth = pixels.getWidth();
+  job.sourceHeight = pixels.getHeight();
+  job.width = width;
+  job.channels = pixels.getNumChannels();
+
+  scratch.resize(width * job.sourceHeight * job.channels);
+  job.scratch = &scratch[0];
+
+  parallelBands(job.sourceHeight, minimumRows(width), resizeHorizontal, &job);
+  parallelBands(height, minimumRows(width), resizeVertical, &job);
+
+  pixels = resized;
+}
@@ -0,0 +1,39 @@
+#ifndef _PixelKernels_h_header
+#define _PixelKernels_h_header
+
+#include "ofMain.h"
+
+// Image processing kernels over ofPixels
+// 
+// Every kernel works in place on 8 bit pixels with 1, 3 or 4 channels. The
+// inner loops use SSE2, or AVX2 when built with -mavx2, and images big
+// enough to be worth it are split into bands of rows processed on worker
+// threads (see Parallel.h).
+class PixelKernels {
+public:
+  PixelKernels();
+
+  void boxBlur(ofPixels& pixels, int radius);
+  void gaussianBlur(ofPixels& pixels, float sigma);
+
+  // kernel holds size*size weights, row major, size odd. Alpha is left as is.
+  void convolve(ofPixels& pixels, float* kernel, int size);
+
+  // Replace color with luma, keeping the channel count and alpha
+  void grayscale(ofPixels& pixels);
+
+  // Color channels above level become 255, everything else 0. Alpha is left as is.
+  void threshold(ofPixels& pixels, int level);
+
+  // Multiply color by alpha, for 4 channel pixels
+  void premultiply(ofPixels& pixels);
+
+  // Resample to width*height with a triangle filter, widened when shrinking
+  // so every source pixel contributes
+  void resize(ofPixels& pixels, int width, int height);
+
+  // intermediate float image, kept between calls to avoid reallocating
+  vector<float> scratch;
+};
+
+#endif /* _PixelKernels_h_header */
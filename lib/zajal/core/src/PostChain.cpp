@@ -0,0 +1,104 @@
+#include "PostChain.h"
+
+PostChain::PostChain() {
+  width = height = 0;
+  timedPass = -1;
+}
+
+PostChain::~PostChain() {
+  for(size_t i = 0; i < buffers.size(); i++)
+    delete buffers[i];
+
+  if(!queries.empty())
+    glDeleteQueries(queries.size(), &queries[0]);
+}
+
+void PostChain::setup(int w, int h, int count) {
+  width = w;
+  height = h;
+
+  for(size_t i = 0; i < buffers.size(); i++)
+    delete buffers[i];
+  buffers.resize(count);
+
+  for(int i = 0; i < count; i++) {
+    buffers[i] = new ofFbo();
+    buffers[i]->allocate(width, height, GL_RGBA);
+  }
+}
+
+void PostChain::begin(int buffer) {
+  buffers[buffer]->begin();
+}
+
+void PostChain::end(int buffer) {
+  buffers[buffer]->end();
+}
+
+void PostChain::growPasses(int pass) {
+  if(pass < (int)cpuTimes.size()) return;
+
+  size_t oldSize = queries.size();
+  cpuStart.resize(pass + 1, 0);
+  cpuTimes.resize(pass + 1, -1.0f);
+  gpuTimes.resize(pass + 1, -1.0f);
+  queryPending.resize(pass + 1, false);
+  queries.resize(pass + 1, 0);
+
+  if(GLEW_ARB_timer_query)
+    glGenQueries(queries.size() - oldSize, &queries[oldSize]);
+}
+
+void PostChain::beginPass(int pass, int target) {
+  growPasses(pass);
+
+  // collect the result of the last query for this pass if it has landed,
+  // and only then start another
+  bool timing = GLEW_ARB_timer_query && queries[pass] != 0;
+  if(timing && queryPending[pass]) {
+    GLint available = 0;
+    glGetQueryObjectiv(queries[pass], GL_QUERY_RESULT_AVAILABLE, &available);
+    if(available) {
+      GLuint64 nanoseconds = 0;
+      glGetQueryObjectui64v(queries[pass], GL_QUERY_RESULT, &nanoseconds);
+      gpuTimes[pass] = nanoseconds / 1000000.0f;
+      queryPending[pass] = false;
+    }
+  }
+
+  cpuStart[pass] = ofGetElapsedTimeMicros();
+  buffers[target]->begin();
+
+  // while a query from an earlier frame is in flight this run goes untimed
+  if(timing && !queryPending[pass]) {
+    glBeginQuery(GL_TIME_ELAPSED, queries[pass]);
+    queryPending[pass] = true;
+    timedPass = pass;
+  }
+}
+
+void PostChain::drawBuffer(int buffer) {
+  buffers[buffer]->draw(0, 0, width, height);
+}
+
+void PostChain::endPass(int pass, int target) {
+  if(timedPass == pass) {
+    glEndQuery(GL_TIME_ELAPSED);
+    timedPass = -1;
+  }
+
+  buffers[target]->end();
+  cpuTimes[pass] = (ofGetElapsedTimeMicros() - cpuStart[pass]) / 1000.0f;
+}
+
+void PostChain::draw(int buffer, float x, float y) {
+  buffers[buffer]->draw(x, y, width, height);
+}
+
+float PostChain::getCpuTime(int pass) {
+  return pass < (int)cpuTimes.size() ? cpuTimes[pass] : -1.0f;
+}
+
+float PostChain::getGpuTime(int pass) {
+  return pass < (int)gpuTimes.size() ? gpuTimes[pass] : -1.0f;
+}
@@ -0,0 +1,53 @@
+#ifndef _PostChain_h_header
+#define _PostChain_h_header
+
+#include "ofMain.h"
+
+// A pool of same-sized framebuffers for multi-pass effects
+// 
+// The caller decides which buffer each pass reads and writes, PostChain
+// owns the buffers and times each pass on the CPU and, where timer queries
+// are available, on the GPU. GPU times arrive a frame or more late, since
+// waiting for them would stall the pipeline.
+class PostChain {
+public:
+  PostChain();
+  ~PostChain();
+
+  // (Re)allocate count buffers of width*height
+  void setup(int width, int height, int count);
+
+  // Render into a buffer outside of any pass, e.g. to capture the scene
+  void begin(int buffer);
+  void end(int buffer);
+
+  // Start a pass rendering into target, with timing
+  void beginPass(int pass, int target);
+
+  // Draw a buffer over the whole of the current target
+  void drawBuffer(int buffer);
+
+  void endPass(int pass, int target);
+
+  // Draw a buffer to the screen
+  void draw(int buffer, float x, float y);
+
+  // Milliseconds the last run of pass took, -1 if unknown
+  float getCpuTime(int pass);
+  float getGpuTime(int pass);
+
+  int width, height;
+  vector<ofFbo*> buffers;
+
+  vector<unsigned long long> cpuStart;
+  vector<float> cpuTimes;
+  vector<float> gpuTimes;
+  vector<GLuint> queries;
+  vector<bool> queryPending;
+  int timedPass;
+
+private:
+  void growPasses(int pass);
+};
+
+#endif /* _PostChain_h_header */
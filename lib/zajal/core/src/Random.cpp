@@ -0,0 +1,148 @@
+#include "Random.h"
+
+#include <cmath>
+
+#define RANDOM_TWO_PI 6.28318530717958647692f
+
+// 2^-24, turns the top 24 bits of a number into a float in 0..1
+#define RANDOM_UNIT (1.0f / 16777216.0f)
+
+#define PCG_MULTIPLIER 6364136223846793005ULL
+
+static inline unsigned long long rotl(unsigned long long x, int k) {
+  return (x << k) | (x >> (64 - k));
+}
+
+// spreads a seed over the xoshiro state, as its authors recommend
+static inline unsigned long long splitmix64(unsigned long long& x) {
+  unsigned long long z = (x += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+RandomStream::RandomStream() {
+  seed(0, 0, RANDOM_XOSHIRO);
+}
+
+// PCG keeps its position in state[0] and its stream in state[1], which has
+// to be odd
+void RandomStream::seed(unsigned int seed, unsigned int stream, int newGenerator) {
+  generator = newGenerator == RANDOM_PCG ? RANDOM_PCG : RANDOM_XOSHIRO;
+  hasSpare = false;
+  spare = 0.0f;
+
+  if(generator == RANDOM_PCG) {
+    state[0] = 0;
+    state[1] = ((unsigned long long)stream << 1) | 1;
+    state[2] = state[3] = 0;
+    next();
+    state[0] += seed;
+    next();
+  } else {
+    unsigned long long x = ((unsigned long long)seed << 32) | stream;
+    for(int i = 0; i < 4; i++)
+      state[i] = splitmix64(x);
+  }
+}
+
+unsigned int RandomStream::next() {
+  if(generator == RANDOM_PCG) {
+    unsigned long long old = state[0];
+    state[0] = old * PCG_MULTIPLIER + state[1];
+    unsigned int shifted = (unsigned int)(((old >> 18) ^ old) >> 27);
+    unsigned int rotation = (unsigned int)(old >> 59);
+    return (shifted >> rotation) | (shifted << ((32 - rotation) & 31));
+  }
+
+  unsigned long long* s = state;
+  unsigned long long result = rotl(s[1] * 5, 7) * 9;
+  unsigned long long t = s[1] << 17;
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = rotl(s[3], 45);
+  return (unsigned int)(result >> 32);
+}
+
+static inline float unit(RandomStream& stream) {
+  return (stream.next() >> 8) * RANDOM_UNIT;
+}
+
+// Lemire's multiply and shift, rejecting the few numbers that would bias
+// it toward the bottom of the range
+static inline unsigned int below(RandomStream& stream, unsigned int range) {
+  unsigned long long m = (unsigned long long)stream.next() * range;
+  unsigned int low = (unsigned int)m;
+  if(low < range) {
+    unsigned int threshold = -range % range;
+    while(low < threshold) {
+      m = (unsigned long long)stream.next() * range;
+      low = (unsigned int)m;
+    }
+  }
+  return (unsigned int)(m >> 32);
+}
+
+// Box-Muller, one pair of standard normals from two uniforms
+static inline void normalPair(RandomStream& stream, float& a, float& b) {
+  float u = ((stream.next() >> 8) + 1) * RANDOM_UNIT; // never 0
+  float v = unit(stream);
+  float radius = sqrtf(-2.0f * logf(u));
+  a = radius * cosf(RANDOM_TWO_PI * v);
+  b = radius * sinf(RANDOM_TWO_PI * v);
+}
+
+float RandomStream::uniform(float low, float high) {
+  return low + unit(*this) * (high - low);
+}
+
+float RandomStream::normal(float mean, float deviation) {
+  if(hasSpare) {
+    hasSpare = false;
+    return mean + spare * deviation;
+  }
+
+  float value;
+  normalPair(*this, value, spare);
+  hasSpare = true;
+  return mean + value * deviation;
+}
+
+int RandomStream::integer(int low, int high) {
+  if(high < low) {
+    int swap = low;
+    low = high;
+    high = swap;
+  }
+
+  unsigned int range = (unsigned int)high - (unsigned int)low + 1;
+  if(range == 0) return (int)next(); // the whole int range
+  return (int)((unsigned int)low + below(*this, range));
+}
+
+void RandomStream::fillUniform(float* out, int count, int stride, float low, float high) {
+  float scale = (high - low) * RANDOM_UNIT;
+  for(int i = 0; i < count; i++, out += stride)
+    *out = low + (next() >> 8) * scale;
+}
+
+void RandomStream::fillNormal(float* out, int count, int stride, float mean, float deviation) {
+  int i = 0;
+  for(; i + 2 <= count; i += 2, out += 2 * stride) {
+    float a, b;
+    normalPair(*this, a, b);
+    out[0] = mean + a * deviation;
+    out[stride] = mean + b * deviation;
+  }
+
+  if(i < count)
+    *out = normal(mean, deviation);
+}
+
+void RandomStream::fillIntegers(float* out, int count, int stride, int low, int high) {
+  for(int i = 0; i < count; i++, out += stride)
+    *out = (float)integer(low, high);
+}
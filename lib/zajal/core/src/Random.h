@@ -0,0 +1,44 @@
+#ifndef _Random_h_header
+#define _Random_h_header
+
+// Which algorithm a RandomStream uses
+enum RandomGenerator {
+  RANDOM_XOSHIRO, // xoshiro256**, the default
+  RANDOM_PCG      // PCG32, smaller state
+};
+
+// A seedable stream of random numbers
+//
+// Streams with the same seed, stream number and generator always produce
+// the same numbers, whatever else the sketch does with randomness, and
+// streams with different stream numbers are independent of each other.
+// Fills are sequential so they stay reproducible; they write every
+// stride'th float of out, so each component of a packed buffer can get its
+// own range.
+class RandomStream {
+public:
+  RandomStream();
+
+  void seed(unsigned int seed, unsigned int stream, int generator);
+
+  // uniform in low..high, excluding high
+  float uniform(float low, float high);
+  float normal(float mean, float deviation);
+  // uniform in low..high, including both
+  int integer(int low, int high);
+
+  void fillUniform(float* out, int count, int stride, float low, float high);
+  void fillNormal(float* out, int count, int stride, float mean, float deviation);
+  void fillIntegers(float* out, int count, int stride, int low, int high);
+
+  unsigned int next();
+
+  unsigned long long state[4];
+  int generator;
+
+  // normals come in pairs, the second is kept for the next call
+  bool hasSpare;
+  float spare;
+};
+
+#endif /* _Random_h_header */
@@ -0,0 +1,119 @@
+#include "ShaderBinaries.h"
+
+#include <cstdio>
+#include <cstring>
+
+static const char ShaderBinaryMagic[4] = { 'Z', 'J', 'S', 'B' };
+
+ShaderBinaries::ShaderBinaries() {}
+
+bool ShaderBinaries::isSupported() {
+#ifdef GL_NUM_PROGRAM_BINARY_FORMATS
+  if(!GLEW_ARB_get_program_binary) return false;
+
+  GLint formats = 0;
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+  return formats > 0;
+#else
+  return false;
+#endif
+}
+
+const char* ShaderBinaries::getDriver() {
+  if(driver.empty()) {
+    const GLubyte* parts[3] = { glGetString(GL_VENDOR), glGetString(GL_RENDERER), glGetString(GL_VERSION) };
+    for(int i = 0; i < 3; i++) {
+      if(parts[i]) driver += (const char*)parts[i];
+      driver += "\n";
+    }
+  }
+
+  return driver.c_str();
+}
+
+void ShaderBinaries::prepare(unsigned int program) {
+#ifdef GL_NUM_PROGRAM_BINARY_FORMATS
+  if(isSupported()) glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+#endif
+}
+
+bool ShaderBinaries::save(unsigned int program, const char* path) {
+#ifdef GL_NUM_PROGRAM_BINARY_FORMATS
+  if(!isSupported()) return false;
+
+  GLint length = 0;
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+  if(length <= 0) return false;
+
+  vector<char> binary(length);
+  GLenum format = 0;
+  glGetProgramBinary(program, length, &length, &format, &binary[0]);
+  if(glGetError() != GL_NO_ERROR) return false;
+
+  FILE* file = fopen(path, "wb");
+  if(!file) return false;
+
+  bool written = fwrite(ShaderBinaryMagic, sizeof(ShaderBinaryMagic), 1, file) == 1 &&
+    fwrite(&format, sizeof(format), 1, file) == 1 &&
+    fwrite(&length, sizeof(length), 1, file) == 1 &&
+    fwrite(&binary[0], length, 1, file) == 1;
+  fclose(file);
+
+  if(!written) remove(path);
+  return written;
+#else
+  return false;
+#endif
+}
+
+unsigned int ShaderBinaries::load(const char* path) {
+#ifdef GL_NUM_PROGRAM_BINARY_FORMATS
+  if(!isSupported()) return 0;
+
+  FILE* file = fopen(path, "rb");
+  if(!file) return 0;
+
+  char magic[sizeof(ShaderBinaryMagic)];
+  GLenum format = 0;
+  GLint length = 0;
+  vector<char> binary;
+
+  bool read = fread(magic, sizeof(magic), 1, file) == 1 && memcmp(magic, ShaderBinaryMagic, sizeof(magic)) == 0 &&
+    fread(&format, sizeof(format), 1, file) == 1 &&
+    fread(&length, sizeof(length), 1, file) == 1 && length > 0;
+  if(read) {
+    binary.resize(length);
+    read = fread(&binary[0], length, 1, file) == 1;
+  }
+  fclose(file);
+  if(!read) return 0;
+
+  // drivers reject binaries from other versions of themselves, in which case
+  // the caller compiles from source as usual
+  GLuint program = glCreateProgram();
+  glProgramBinary(program, format, &binary[0], length);
+
+  GLint linked = GL_FALSE;
+  glGetProgramiv(program, GL_LINK_STATUS, &linked);
+  if(linked != GL_TRUE) {
+    glDeleteProgram(program);
+    return 0;
+  }
+
+  return program;
+#else
+  return 0;
+#endif
+}
+
+void ShaderBinaries::unload(unsigned int program) {
+  if(program) glDeleteProgram(program);
+}
+
+void ShaderBinaries::begin(unsigned int program) {
+  glUseProgram(program);
+}
+
+void ShaderBinaries::end() {
+  glUseProgram(0);
+}
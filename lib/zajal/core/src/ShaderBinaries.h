@@ -0,0 +1,39 @@
+#ifndef _ShaderBinaries_h_header
+#define _ShaderBinaries_h_header
+
+#include "ofMain.h"
+
+// Saves linked programs to disk and loads them back without compiling
+// 
+// Uses glGetProgramBinary/glProgramBinary. Binaries only work on the driver
+// that produced them, so callers should key files by getDriver(). Drivers
+// that can't produce binaries (llvmpipe, most notably) report
+// isSupported() false, and a binary that fails to load is simply a miss.
+class ShaderBinaries {
+public:
+  ShaderBinaries();
+
+  bool isSupported();
+
+  // Vendor, renderer and version of the current GL driver
+  const char* getDriver();
+
+  // Ask the driver to keep a binary of program around. Call before linking.
+  void prepare(unsigned int program);
+
+  bool save(unsigned int program, const char* path);
+
+  // Returns a new linked program, or 0 if path couldn't be loaded
+  unsigned int load(const char* path);
+
+  // Delete a program returned by load
+  void unload(unsigned int program);
+
+  // Use a program that has no ofShader
+  void begin(unsigned int program);
+  void end();
+
+  string driver;
+};
+
+#endif /* _ShaderBinaries_h_header */
@@ -0,0 +1,96 @@
+#include "ShaderUniforms.h"
+
+ShaderUniforms::ShaderUniforms() {
+  program = 0;
+}
+
+// out of line, so Ruby has a destructor to attach
+ShaderUniforms::~ShaderUniforms() {}
+
+int ShaderUniforms::setup(unsigned int linkedProgram) {
+  program = linkedProgram;
+  uniforms.clear();
+
+  GLint count = 0, maxLength = 0;
+  glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+  glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+  vector<GLchar> name(maxLength + 1);
+  for(GLint i = 0; i < count; i++) {
+    Uniform uniform;
+    GLsizei length = 0;
+    glGetActiveUniform(program, i, maxLength + 1, &length, &uniform.size, &uniform.type, &name[0]);
+    uniform.location = glGetUniformLocation(program, &name[0]);
+
+    // arrays are reported as "name[0]", make them reachable as "name" too
+    string key(&name[0], length);
+    uniforms[key] = uniform;
+    if(key.size() > 3 && key.compare(key.size() - 3, 3, "[0]") == 0)
+      uniforms[key.substr(0, key.size() - 3)] = uniform;
+  }
+
+  return count;
+}
+
+bool ShaderUniforms::describe(const char* name, int* info) {
+  map<string, Uniform>::iterator it = uniforms.find(name);
+  if(it == uniforms.end()) return false;
+
+  info[0] = it->second.location;
+  info[1] = it->second.type;
+  info[2] = it->second.size;
+  return true;
+}
+
+void ShaderUniforms::upload(int* records, float* values, int count) {
+  for(int i = 0; i < count; i++, records += 4) {
+    GLint location = records[0];
+    int components = records[2];
+    int length = records[3];
+    int n = components * length;
+
+    if(location < 0) {
+      values += n;
+      continue;
+    }
+
+    switch(records[1]) {
+      case SHADER_UNIFORM_FLOAT:
+        switch(components) {
+          case 1: glUniform1fv(location, length, values); break;
+          case 2: glUniform2fv(location, length, values); break;
+          case 3: glUniform3fv(location, length, values); break;
+          case 4: glUniform4fv(location, length, values); break;
+        }
+        break;
+
+      case SHADER_UNIFORM_INT:
+        ints.resize(n);
+        for(int j = 0; j < n; j++) ints[j] = (GLint)values[j];
+        switch(components) {
+          case 1: glUniform1iv(location, length, &ints[0]); break;
+          case 2: glUniform2iv(location, length, &ints[0]); break;
+          case 3: glUniform3iv(location, length, &ints[0]); break;
+          case 4: glUniform4iv(location, length, &ints[0]); break;
+        }
+        break;
+
+      case SHADER_UNIFORM_MATRIX:
+        switch(components) {
+          case 4: glUniformMatrix2fv(location, length, GL_FALSE, values); break;
+          case 9: glUniformMatrix3fv(location, length, GL_FALSE, values); break;
+          case 16: glUniformMatrix4fv(location, length, GL_FALSE, values); break;
+        }
+        break;
+    }
+
+    values += n;
+  }
+}
+
+void ShaderUniforms::setTexture(int location, ofTexture& texture, int unit) {
+  glActiveTexture(GL_TEXTURE0 + unit);
+  texture.bind();
+  glUniform1i(location, unit);
+  glActiveTexture(GL_TEXTURE0);
+}
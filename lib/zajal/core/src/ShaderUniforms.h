@@ -0,0 +1,52 @@
+#ifndef _ShaderUniforms_h_header
+#define _ShaderUniforms_h_header
+
+#include "ofMain.h"
+
+// Record layout for ShaderUniforms::upload
+enum ShaderUniformKind {
+  SHADER_UNIFORM_FLOAT = 0,
+  SHADER_UNIFORM_INT = 1,
+  SHADER_UNIFORM_MATRIX = 2
+};
+
+// Uniform locations of a linked program, looked up once
+// 
+// ofShader looks a uniform's location up by name every time it is set.
+// ShaderUniforms asks the program for all of its active uniforms once after
+// linking, and sets uniforms by location from then on.
+class ShaderUniforms {
+public:
+  ShaderUniforms();
+  ~ShaderUniforms();
+
+  // Read the active uniforms of a linked program. Call again after
+  // relinking. Returns the number of active uniforms.
+  int setup(unsigned int program);
+
+  // Fill info with the location, GL type and array size of the named
+  // uniform. Returns false, leaving info alone, if there is no such uniform.
+  bool describe(const char* name, int* info);
+
+  // Set count uniforms in one go. records holds count records of 4 ints:
+  // location, ShaderUniformKind, components (1-4, or 4, 9 or 16 for 2x2, 3x3
+  // and 4x4 matrices) and
+  // array length. values holds the values of every record back to back;
+  // ints are passed as floats.
+  void upload(int* records, float* values, int count);
+
+  // Bind texture to unit and point the sampler at location to it
+  void setTexture(int location, ofTexture& texture, int unit);
+
+  struct Uniform {
+    GLint location;
+    GLenum type;
+    GLint size;
+  };
+
+  GLuint program;
+  map<string, Uniform> uniforms;
+  vector<GLint> ints;
+};
+
+#endif /* _ShaderUniforms_h_header */
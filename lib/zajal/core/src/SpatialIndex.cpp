@@ -0,0 +1,532 @@
+#include "SpatialIndex.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+// fewest buckets a hash keeps, always a power of two
+#define SPATIAL_MIN_BUCKETS 64
+
+// most points a k-d tree leaf holds
+#define KD_LEAF_SIZE 8
+
+// points per thread below which neighbourhoods stays on one thread
+#define SPATIAL_MIN_PER_JOB 2048
+
+// far enough out that nothing will be there, near enough that differences
+// between cells don't overflow
+#define SPATIAL_CELL_LIMIT 1000000000
+
+typedef pair<float, int> Candidate;
+
+static inline int cellIndex(float v) {
+  v = floorf(v);
+  if(v < -SPATIAL_CELL_LIMIT) return -SPATIAL_CELL_LIMIT;
+  if(v > SPATIAL_CELL_LIMIT) return SPATIAL_CELL_LIMIT;
+  return (int)v;
+}
+
+static inline float distance2(const SpatialPoints& points, int i, float x, float y, float z) {
+  float dx = points.px(i) - x, dy = points.py(i) - y, dz = points.pz(i) - z;
+  return dx * dx + dy * dy + dz * dz;
+}
+
+static inline SpatialPoints spatialPoints(float* x, float* y, float* z, int stride, int count) {
+  SpatialPoints points = { x, y, z, stride < 1 ? 1 : stride, count < 0 ? 0 : count };
+  return points;
+}
+
+static inline int* firstOf(vector<int>& v) {
+  return v.empty() ? NULL : &v[0];
+}
+
+/*
+ * queries shared by both indexes
+ */
+
+struct PushVisitor {
+  vector<int>* out;
+  void operator()(int i) { out->push_back(i); }
+};
+
+struct CountVisitor {
+  int skip, n;
+  void operator()(int i) { if(i != skip) n++; }
+};
+
+struct WriteVisitor {
+  int skip;
+  int* out;
+  void operator()(int i) { if(i != skip) *out++ = i; }
+};
+
+// keep the k closest candidates in a max heap
+static inline void offer(vector<Candidate>& heap, int k, float d2, int index) {
+  if((int)heap.size() < k) {
+    heap.push_back(Candidate(d2, index));
+    push_heap(heap.begin(), heap.end());
+  } else if(d2 < heap.front().first) {
+    pop_heap(heap.begin(), heap.end());
+    heap.back() = Candidate(d2, index);
+    push_heap(heap.begin(), heap.end());
+  }
+}
+
+static int finishNearest(vector<Candidate>& heap, vector<int>& results) {
+  sort_heap(heap.begin(), heap.end());
+  results.resize(heap.size());
+  for(size_t i = 0; i < heap.size(); i++)
+    results[i] = heap[i].second;
+  return results.size();
+}
+
+template <class Index> struct NeighbourhoodJob {
+  const Index* index;
+  float radius;
+  int* offsets;
+  int* results;
+};
+
+template <class Index> static void countRange(void* context, int begin, int end) {
+  NeighbourhoodJob<Index>* job = (NeighbourhoodJob<Index>*)context;
+  const SpatialPoints& points = job->index->points;
+
+  for(int i = begin; i < end; i++) {
+    CountVisitor visit = { i, 0 };
+    job->index->visitWithin(points.px(i), points.py(i), points.pz(i), job->radius, visit);
+    job->offsets[i + 1] = visit.n;
+  }
+}
+
+template <class Index> static void writeRange(void* context, int begin, int end) {
+  NeighbourhoodJob<Index>* job = (NeighbourhoodJob<Index>*)context;
+  const SpatialPoints& points = job->index->points;
+
+  for(int i = begin; i < end; i++) {
+    WriteVisitor visit = { i, job->results + job->offsets[i] };
+    job->index->visitWithin(points.px(i), points.py(i), points.pz(i), job->radius, visit);
+  }
+}
+
+// Count every point's neighbours, then write them where the counts say,
+// so both passes can run across threads without sharing output
+template <class Index> static int findNeighbourhoods(const Index* index, float radius, vector<int>& offsets, vector<int>& results) {
+  int count = index->points.count;
+  offsets.assign(count + 1, 0);
+  results.clear();
+  if(count == 0) return 0;
+
+  NeighbourhoodJob<Index> job = { index, radius, &offsets[0], NULL };
+  parallelBands(count, SPATIAL_MIN_PER_JOB, countRange<Index>, &job);
+
+  for(int i = 0; i < count; i++)
+    offsets[i + 1] += offsets[i];
+
+  results.resize(offsets[count]);
+  if(results.empty()) return 0;
+
+  job.results = &results[0];
+  parallelBands(count, SPATIAL_MIN_PER_JOB, writeRange<Index>, &job);
+  return results.size();
+}
+
+/*
+ * SpatialHash
+ */
+
+SpatialHash::SpatialHash() {
+  points = spatialPoints(NULL, NULL, NULL, 1, 0);
+  cellSize = 1.0f;
+  lowX = lowY = lowZ = INT_MAX;
+  highX = highY = highZ = INT_MIN;
+}
+
+void SpatialHash::setup(float newCellSize) {
+  cellSize = newCellSize > 0.0f ? newCellSize : 1.0f;
+  rebuild();
+}
+
+void SpatialHash::load(float* x, float* y, float* z, int stride, int count) {
+  points = spatialPoints(x, y, z, stride, count);
+  rebuild();
+}
+
+int SpatialHash::bucketFor(int cx, int cy, int cz) const {
+  unsigned int h = (unsigned int)cx * 73856093u ^ (unsigned int)cy * 19349663u ^ (unsigned int)cz * 83492791u;
+  return h & (buckets.size() - 1);
+}
+
+void SpatialHash::widenBounds(int i) {
+  lowX = min(lowX, cellX[i]); highX = max(highX, cellX[i]);
+  lowY = min(lowY, cellY[i]); highY = max(highY, cellY[i]);
+  lowZ = min(lowZ, cellZ[i]); highZ = max(highZ, cellZ[i]);
+}
+
+void SpatialHash::insert(int i) {
+  cellX[i] = cellIndex(points.px(i) / cellSize);
+  cellY[i] = cellIndex(points.py(i) / cellSize);
+  cellZ[i] = cellIndex(points.pz(i) / cellSize);
+  widenBounds(i);
+
+  int b = bucketFor(cellX[i], cellY[i], cellZ[i]);
+  bucketOf[i] = b;
+  slotOf[i] = buckets[b].size();
+  buckets[b].push_back(i);
+}
+
+// swap the bucket's last point into i's slot
+void SpatialHash::remove(int i) {
+  vector<int>& bucket = buckets[bucketOf[i]];
+  int last = bucket.back();
+  bucket[slotOf[i]] = last;
+  slotOf[last] = slotOf[i];
+  bucket.pop_back();
+}
+
+void SpatialHash::rebuild() {
+  int count = points.count;
+
+  size_t size = SPATIAL_MIN_BUCKETS;
+  while(size < (size_t)count) size <<= 1;
+  buckets.resize(size);
+  for(size_t b = 0; b < size; b++)
+    buckets[b].clear();
+
+  cellX.resize(count); cellY.resize(count); cellZ.resize(count);
+  bucketOf.resize(count); slotOf.resize(count);
+
+  lowX = lowY = lowZ = INT_MAX;
+  highX = highY = highZ = INT_MIN;
+  for(int i = 0; i < count; i++)
+    insert(i);
+}
+
+void SpatialHash::refresh(int count) {
+  if(count < 0) count = 0;
+  if(count > (int)buckets.size()) {
+    points.count = count;
+    rebuild();
+    return;
+  }
+
+  int old = points.count;
+  for(int i = count; i < old; i++)
+    remove(i);
+
+  points.count = count;
+  cellX.resize(count); cellY.resize(count); cellZ.resize(count);
+  bucketOf.resize(count); slotOf.resize(count);
+
+  lowX = lowY = lowZ = INT_MAX;
+  highX = highY = highZ = INT_MIN;
+
+  int kept = min(old, count);
+  for(int i = 0; i < kept; i++) {
+    if(cellIndex(points.px(i) / cellSize) == cellX[i] &&
+       cellIndex(points.py(i) / cellSize) == cellY[i] &&
+       cellIndex(points.pz(i) / cellSize) == cellZ[i]) {
+      widenBounds(i);
+    } else {
+      remove(i);
+      insert(i);
+    }
+  }
+
+  for(int i = kept; i < count; i++)
+    insert(i);
+}
+
+void SpatialHash::update(int index) {
+  if(index < 0 || index >= points.count) return;
+  remove(index);
+  insert(index);
+}
+
+// several cells can share a bucket, so points are checked against the cell
+// being visited to never visit them twice
+template <class Visitor> void SpatialHash::visitWithin(float x, float y, float z, float radius, Visitor& visit) const {
+  if(points.count == 0 || radius < 0.0f) return;
+  if(!points.z) z = 0.0f;
+
+  float radius2 = radius * radius;
+  int x0 = max(cellIndex((x - radius) / cellSize), lowX), x1 = min(cellIndex((x + radius) / cellSize), highX);
+  int y0 = max(cellIndex((y - radius) / cellSize), lowY), y1 = min(cellIndex((y + radius) / cellSize), highY);
+  int z0 = max(cellIndex((z - radius) / cellSize), lowZ), z1 = min(cellIndex((z + radius) / cellSize), highZ);
+
+  for(int cz = z0; cz <= z1; cz++)
+    for(int cy = y0; cy <= y1; cy++)
+      for(int cx = x0; cx <= x1; cx++) {
+        const vector<int>& bucket = buckets[bucketFor(cx, cy, cz)];
+        for(size_t j = 0; j < bucket.size(); j++) {
+          int i = bucket[j];
+          if(cellX[i] == cx && cellY[i] == cy && cellZ[i] == cz && distance2(points, i, x, y, z) <= radius2)
+            visit(i);
+        }
+      }
+}
+
+int SpatialHash::within(float x, float y, float z, float radius) {
+  results.clear();
+  PushVisitor visit = { &results };
+  visitWithin(x, y, z, radius, visit);
+  return results.size();
+}
+
+static inline void offerCell(const SpatialHash& hash, int cx, int cy, int cz, float x, float y, float z, int k, vector<Candidate>& heap) {
+  const vector<int>& bucket = hash.buckets[hash.bucketFor(cx, cy, cz)];
+  for(size_t j = 0; j < bucket.size(); j++) {
+    int i = bucket[j];
+    if(hash.cellX[i] == cx && hash.cellY[i] == cy && hash.cellZ[i] == cz)
+      offer(heap, k, distance2(hash.points, i, x, y, z), i);
+  }
+}
+
+// Search rings of cells outward from the query's cell. Once ring L is
+// done, every point left is at least L cells away.
+int SpatialHash::nearest(float x, float y, float z, int k) {
+  candidates.clear();
+  if(k > points.count) k = points.count;
+  if(k <= 0) {
+    results.clear();
+    return 0;
+  }
+  if(!points.z) z = 0.0f;
+
+  int qx = cellIndex(x / cellSize), qy = cellIndex(y / cellSize), qz = cellIndex(z / cellSize);
+
+  // rings closer than this miss every point, and past this cover them all
+  int first = max(max(max(lowX - qx, qx - highX), max(lowY - qy, qy - highY)), max(max(lowZ - qz, qz - highZ), 0));
+  int last = max(max(max(qx - lowX, highX - qx), max(qy - lowY, highY - qy)), max(qz - lowZ, highZ - qz));
+
+  for(int ring = first; ring <= last; ring++) {
+    int y0 = max(qy - ring, lowY), y1 = min(qy + ring, highY);
+    int z0 = max(qz - ring, lowZ), z1 = min(qz + ring, highZ);
+
+    for(int cz = z0; cz <= z1; cz++)
+      for(int cy = y0; cy <= y1; cy++) {
+        if(abs(cy - qy) == ring || abs(cz - qz) == ring) {
+          // on the ring's face, visit the whole row
+          int x0 = max(qx - ring, lowX), x1 = min(qx + ring, highX);
+          for(int cx = x0; cx <= x1; cx++)
+            offerCell(*this, cx, cy, cz, x, y, z, k, candidates);
+        } else {
+          // inside it, only the row's two ends are on the ring
+          if(qx - ring >= lowX) offerCell(*this, qx - ring, cy, cz, x, y, z, k, candidates);
+          if(qx + ring <= highX) offerCell(*this, qx + ring, cy, cz, x, y, z, k, candidates);
+        }
+      }
+
+    float reach = ring * cellSize;
+    if((int)candidates.size() == k && candidates.front().first <= reach * reach) break;
+  }
+
+  return finishNearest(candidates, results);
+}
+
+int SpatialHash::neighbourhoods(float radius) {
+  return findNeighbourhoods(this, radius, offsets, results);
+}
+
+int* SpatialHash::getResults() {
+  return firstOf(results);
+}
+
+int* SpatialHash::getOffsets() {
+  return firstOf(offsets);
+}
+
+/*
+ * KdTree
+ */
+
+struct KdAxisLess {
+  const SpatialPoints* points;
+  int axis;
+
+  inline float at(int i) const {
+    return axis == 0 ? points->px(i) : axis == 1 ? points->py(i) : points->pz(i);
+  }
+
+  bool operator()(int a, int b) const { return at(a) < at(b); }
+};
+
+// squared distance from (x, y, z) to the node's bounds, 0 inside them
+static inline float boxDistance2(const KdNode& node, float x, float y, float z) {
+  float q[3] = { x, y, z };
+  float sum = 0.0f;
+  for(int axis = 0; axis < 3; axis++) {
+    float d = max(max(node.low[axis] - q[axis], q[axis] - node.high[axis]), 0.0f);
+    sum += d * d;
+  }
+  return sum;
+}
+
+KdTree::KdTree() {
+  points = spatialPoints(NULL, NULL, NULL, 1, 0);
+}
+
+void KdTree::load(float* x, float* y, float* z, int stride, int count) {
+  points = spatialPoints(x, y, z, stride, count);
+  rebuild();
+}
+
+void KdTree::rebuild() {
+  int count = points.count;
+  order.resize(count);
+  for(int i = 0; i < count; i++)
+    order[i] = i;
+
+  nodes.clear();
+  nodes.reserve(4 * count / KD_LEAF_SIZE + 1);
+  if(count > 0) build(0, count);
+}
+
+// nodes are added parent first, so children always come after parents
+int KdTree::build(int begin, int end) {
+  int index = nodes.size();
+  KdNode node = { { 0, 0, 0 }, { 0, 0, 0 }, begin, end, -1, -1 };
+  nodes.push_back(node);
+  fit(index);
+
+  if(end - begin <= KD_LEAF_SIZE) return index;
+
+  // split the widest axis at the median
+  KdNode& bounds = nodes[index];
+  int dimensions = points.z ? 3 : 2;
+  KdAxisLess less = { &points, 0 };
+  for(int axis = 1; axis < dimensions; axis++)
+    if(bounds.high[axis] - bounds.low[axis] > bounds.high[less.axis] - bounds.low[less.axis])
+      less.axis = axis;
+
+  int middle = (begin + end) / 2;
+  nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end, less);
+
+  int left = build(begin, middle);
+  int right = build(middle, end);
+  nodes[index].left = left;
+  nodes[index].right = right;
+  return index;
+}
+
+// bounds of a leaf's points, or of an inner node's children
+void KdTree::fit(int index) {
+  KdNode& node = nodes[index];
+
+  if(node.left >= 0) {
+    const KdNode& left = nodes[node.left];
+    const KdNode& right = nodes[node.right];
+    for(int axis = 0; axis < 3; axis++) {
+      node.low[axis] = min(left.low[axis], right.low[axis]);
+      node.high[axis] = max(left.high[axis], right.high[axis]);
+    }
+    return;
+  }
+
+  int first = order[node.begin];
+  node.low[0] = node.high[0] = points.px(first);
+  node.low[1] = node.high[1] = points.py(first);
+  node.low[2] = node.high[2] = points.pz(first);
+
+  for(int j = node.begin + 1; j < node.end; j++) {
+    int i = order[j];
+    float p[3] = { points.px(i), points.py(i), points.pz(i) };
+    for(int axis = 0; axis < 3; axis++) {
+      node.low[axis] = min(node.low[axis], p[axis]);
+      node.high[axis] = max(node.high[axis], p[axis]);
+    }
+  }
+}
+
+void KdTree::refresh(int count) {
+  if(count < 0) count = 0;
+  if(count != points.count) {
+    points.count = count;
+    rebuild();
+    return;
+  }
+
+  // children come after parents, so going backwards fits them first
+  for(int index = nodes.size() - 1; index >= 0; index--)
+    fit(index);
+}
+
+template <class Visitor> void KdTree::visitWithin(float x, float y, float z, float radius, Visitor& visit) const {
+  if(nodes.empty() || radius < 0.0f) return;
+  if(!points.z) z = 0.0f;
+
+  float radius2 = radius * radius;
+  int stack[128];
+  int depth = 0;
+  stack[depth++] = 0;
+
+  while(depth > 0) {
+    const KdNode& node = nodes[stack[--depth]];
+    if(boxDistance2(node, x, y, z) > radius2) continue;
+
+    if(node.left < 0) {
+      for(int j = node.begin; j < node.end; j++)
+        if(distance2(points, order[j], x, y, z) <= radius2)
+          visit(order[j]);
+    } else {
+      stack[depth++] = node.right;
+      stack[depth++] = node.left;
+    }
+  }
+}
+
+int KdTree::within(float x, float y, float z, float radius) {
+  results.clear();
+  PushVisitor visit = { &results };
+  visitWithin(x, y, z, radius, visit);
+  return results.size();
+}
+
+// visit the nearer child first, so the farther one is more often skipped
+static void searchNearest(const KdTree& tree, int index, float x, float y, float z, int k, vector<Candidate>& heap) {
+  const KdNode& node = tree.nodes[index];
+
+  if(node.left < 0) {
+    for(int j = node.begin; j < node.end; j++)
+      offer(heap, k, distance2(tree.points, tree.order[j], x, y, z), tree.order[j]);
+    return;
+  }
+
+  int near = node.left, far = node.right;
+  float nearDistance = boxDistance2(tree.nodes[near], x, y, z);
+  float farDistance = boxDistance2(tree.nodes[far], x, y, z);
+  if(farDistance < nearDistance) {
+    swap(near, far);
+    swap(nearDistance, farDistance);
+  }
+
+  if((int)heap.size() < k || nearDistance < heap.front().first)
+    searchNearest(tree, near, x, y, z, k, heap);
+  if((int)heap.size() < k || farDistance < heap.front().first)
+    searchNearest(tree, far, x, y, z, k, heap);
+}
+
+int KdTree::nearest(float x, float y, float z, int k) {
+  candidates.clear();
+  if(k > points.count) k = points.count;
+  if(k <= 0 || nodes.empty()) {
+    results.clear();
+    return 0;
+  }
+  if(!points.z) z = 0.0f;
+
+  searchNearest(*this, 0, x, y, z, k, candidates);
+  return finishNearest(candidates, results);
+}
+
+int KdTree::neighbourhoods(float radius) {
+  return findNeighbourhoods(this, radius, offsets, results);
+}
+
+int* KdTree::getResults() {
+  return firstOf(results);
+}
+
+int* KdTree::getOffsets() {
+  return firstOf(offsets);
+}
@@ -0,0 +1,127 @@
+#ifndef _SpatialIndex_h_header
+#define _SpatialIndex_h_header
+
+#include "ofMain.h"
+
+// Points an index reads in place, without copying them
+//
+// Point i is (x[i * stride], y[i * stride], z[i * stride]), so both packed
+// buffers (x, x + 1, x + 2 with a stride of components) and separate
+// coordinate arrays (a stride of 1) work. z is NULL for 2D points.
+struct SpatialPoints {
+  float* x;
+  float* y;
+  float* z;
+  int stride;
+  int count;
+
+  inline float px(int i) const { return x[i * stride]; }
+  inline float py(int i) const { return y[i * stride]; }
+  inline float pz(int i) const { return z ? z[i * stride] : 0.0f; }
+};
+
+// Both indexes answer queries the same way: the matching indices are
+// written into results, and the query returns how many there are.
+// nearest() sorts them closest first. neighbourhoods() finds every point's
+// neighbours at once, with point i's neighbours at
+// results[offsets[i]] .. results[offsets[i + 1]], not including i itself.
+//
+// The points must stay where they are for as long as they are indexed.
+// After moving them call refresh(), passing the new count if points were
+// added or removed at the end.
+
+// Points binned into a hashed grid of square cells
+//
+// Cheapest to keep up to date, so best for points that move every frame
+// and radius queries around the cell size.
+class SpatialHash {
+public:
+  SpatialHash();
+
+  void setup(float cellSize);
+  void load(float* x, float* y, float* z, int stride, int count);
+
+  // Re-bin only the points that changed cell
+  void refresh(int count);
+  void update(int index);
+
+  int within(float x, float y, float z, float radius);
+  int nearest(float x, float y, float z, int k);
+  int neighbourhoods(float radius);
+
+  int* getResults();
+  int* getOffsets();
+
+  // calls visit(index) for every point within radius
+  template <class Visitor> void visitWithin(float x, float y, float z, float radius, Visitor& visit) const;
+  int bucketFor(int cx, int cy, int cz) const;
+
+  SpatialPoints points;
+  float cellSize;
+
+  vector< vector<int> > buckets;
+  vector<int> cellX, cellY, cellZ;
+  vector<int> bucketOf, slotOf;
+
+  // cells every point is within, to bound queries
+  int lowX, lowY, lowZ, highX, highY, highZ;
+
+  vector<int> results, offsets;
+  vector< pair<float, int> > candidates;
+
+private:
+  void rebuild();
+  void insert(int index);
+  void remove(int index);
+  void widenBounds(int index);
+};
+
+// A k-d tree node, a leaf when left is -1. Bounds are kept per node so the
+// tree can be refit after points move instead of rebuilt.
+struct KdNode {
+  float low[3], high[3];
+  int begin, end;
+  int left, right;
+};
+
+// Points split into a balanced k-d tree
+//
+// Best for nearest neighbour queries and for points that are unevenly
+// spread out. refresh() refits the tree around moved points, which keeps
+// queries correct but slower the further points move, so reload every so
+// often when they move a lot.
+class KdTree {
+public:
+  KdTree();
+
+  void load(float* x, float* y, float* z, int stride, int count);
+
+  // Refit the tree to where the points are now, rebuilding it if the
+  // count changed
+  void refresh(int count);
+
+  int within(float x, float y, float z, float radius);
+  int nearest(float x, float y, float z, int k);
+  int neighbourhoods(float radius);
+
+  int* getResults();
+  int* getOffsets();
+
+  template <class Visitor> void visitWithin(float x, float y, float z, float radius, Visitor& visit) const;
+
+  SpatialPoints points;
+
+  // point indices, each node owns a contiguous range of them
+  vector<int> order;
+  vector<KdNode> nodes;
+
+  vector<int> results, offsets;
+  vector< pair<float, int> > candidates;
+
+private:
+  void rebuild();
+  int build(int begin, int end);
+  void fit(int node);
+};
+
+#endif /* _SpatialIndex_h_header */
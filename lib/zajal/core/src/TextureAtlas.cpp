@@ -0,0 +1,198 @@
+#include "TextureAtlas.h"
+#include <algorithm>
+#include <cstring>
+
+struct SkylineNode {
+  int x, y, width;
+};
+
+typedef vector<SkylineNode> Skyline;
+
+// y position a w*h rectangle would rest at if its left edge sat on node i,
+// or -1 if it doesn't fit there
+static int skylineFit(const Skyline& skyline, int i, int w, int h, int pageWidth, int pageHeight) {
+  int x = skyline[i].x;
+  if(x + w > pageWidth) return -1;
+
+  int y = skyline[i].y;
+  int widthLeft = w;
+  while(widthLeft > 0) {
+    y = max(y, skyline[i].y);
+    if(y + h > pageHeight) return -1;
+    widthLeft -= skyline[i].width;
+    i++;
+  }
+
+  return y;
+}
+
+static bool skylineInsert(Skyline& skyline, int w, int h, int pageWidth, int pageHeight, int& x, int& y) {
+  int bestIndex = -1, bestBottom = pageHeight + 1, bestWidth = pageWidth + 1;
+
+  for(size_t i = 0; i < skyline.size(); i++) {
+    int fitY = skylineFit(skyline, i, w, h, pageWidth, pageHeight);
+    if(fitY < 0) continue;
+
+    if(fitY + h < bestBottom || (fitY + h == bestBottom && skyline[i].width < bestWidth)) {
+      bestIndex = i;
+      bestBottom = fitY + h;
+      bestWidth = skyline[i].width;
+      x = skyline[i].x;
+      y = fitY;
+    }
+  }
+
+  if(bestIndex < 0) return false;
+
+  SkylineNode node = { x, y + h, w };
+  skyline.insert(skyline.begin() + bestIndex, node);
+
+  // trim the segments the new node now shadows
+  for(size_t i = bestIndex + 1; i < skyline.size(); i++) {
+    int shadow = skyline[i-1].x + skyline[i-1].width - skyline[i].x;
+    if(shadow <= 0) break;
+
+    skyline[i].x += shadow;
+    skyline[i].width -= shadow;
+    if(skyline[i].width > 0) break;
+
+    skyline.erase(skyline.begin() + i);
+    i--;
+  }
+
+  // merge neighbours at the same height
+  for(size_t i = 0; i + 1 < skyline.size(); i++) {
+    if(skyline[i].y == skyline[i+1].y) {
+      skyline[i].width += skyline[i+1].width;
+      skyline.erase(skyline.begin() + i + 1);
+      i--;
+    }
+  }
+
+  return true;
+}
+
+struct TallestFirst {
+  const int* rects;
+  bool operator()(int a, int b) const {
+    const int* ra = rects + a * 5;
+    const int* rb = rects + b * 5;
+    return ra[1] != rb[1] ? ra[1] > rb[1] : ra[0] > rb[0];
+  }
+};
+
+TextureAtlas::TextureAtlas() {
+  setup(1024, 1024, 1);
+}
+
+void TextureAtlas::setup(int w, int h, int pad) {
+  pageWidth = w;
+  pageHeight = h;
+  padding = pad;
+}
+
+int TextureAtlas::pack(int* rects, int count) {
+  vector<int> order(count);
+  for(int i = 0; i < count; i++) order[i] = i;
+
+  TallestFirst tallestFirst = { rects };
+  stable_sort(order.begin(), order.end(), tallestFirst);
+
+  vector<Skyline> pages;
+
+  for(int n = 0; n < count; n++) {
+    int* rect = rects + order[n] * 5;
+    int w = rect[0] + padding;
+    int h = rect[1] + padding;
+    int x = 0, y = 0;
+
+    rect[2] = -1;
+    rect[3] = rect[4] = 0;
+    if(w > pageWidth || h > pageHeight) continue;
+
+    size_t page = 0;
+    for(; page < pages.size(); page++)
+      if(skylineInsert(pages[page], w, h, pageWidth, pageHeight, x, y)) break;
+
+    if(page == pages.size()) {
+      SkylineNode floor = { 0, 0, pageWidth };
+      pages.push_back(Skyline(1, floor));
+      skylineInsert(pages[page], w, h, pageWidth, pageHeight, x, y);
+    }
+
+    rect[2] = page;
+    rect[3] = x;
+    rect[4] = y;
+  }
+
+  return pages.size();
+}
+
+void TextureAtlas::allocate(ofImage& page) {
+  page.allocate(pageWidth, pageHeight, OF_IMAGE_COLOR_ALPHA);
+  memset(page.getPixels(), 0, pageWidth * pageHeight * 4);
+}
+
+void TextureAtlas::blit(ofImage& page, ofPixels& sprite, int x, int y) {
+  ofPixels& dst = page.getPixelsRef();
+
+  int dstChannels = dst.getNumChannels();
+  int srcChannels = sprite.getNumChannels();
+  int w = min(sprite.getWidth(), dst.getWidth() - x);
+  int h = min(sprite.getHeight(), dst.getHeight() - y);
+
+  for(int row = 0; row < h; row++) {
+    unsigned char* d = dst.getPixels() + ((y + row) * dst.getWidth() + x) * dstChannels;
+    unsigned char* s = sprite.getPixels() + row * sprite.getWidth() * srcChannels;
+
+    if(srcChannels == dstChannels) {
+      memcpy(d, s, w * dstChannels);
+      continue;
+    }
+
+    for(int col = 0; col < w; col++, d += dstChannels, s += srcChannels) {
+      unsigned char gray = s[0];
+      d[0] = gray;
+      if(dstChannels > 1) {
+        d[1] = srcChannels >= 3 ? s[1] : gray;
+        d[2] = srcChannels >= 3 ? s[2] : gray;
+      }
+      if(dstChannels == 4)
+        d[3] = srcChannels == 4 ? s[3] : 255;
+    }
+  }
+}
+
+SpriteBatch::SpriteBatch() {}
+
+void SpriteBatch::draw(ofImage& page, float* quads, int count) {
+  ofTexture& texture = page.getTextureReference();
+
+  vertices.resize(count * 12);
+  texCoords.resize(count * 12);
+
+  float* v = &vertices[0];
+  float* t = &texCoords[0];
+  for(int i = 0; i < count; i++, quads += 8, v += 12, t += 12) {
+    // texture coordinates depend on the texture target, let ofTexture map them
+    ofPoint t0 = texture.getCoordFromPoint(quads[0], quads[1]);
+    ofPoint t1 = texture.getCoordFromPoint(quads[0] + quads[2], quads[1] + quads[3]);
+    float x0 = quads[4], y0 = quads[5], x1 = quads[4] + quads[6], y1 = quads[5] + quads[7];
+
+    // two triangles per quad
+    float quadVertices[12]  = { x0, y0,  x1, y0,  x1, y1,  x0, y0,  x1, y1,  x0, y1 };
+    float quadTexCoords[12] = { t0.x, t0.y,  t1.x, t0.y,  t1.x, t1.y,  t0.x, t0.y,  t1.x, t1.y,  t0.x, t1.y };
+    memcpy(v, quadVertices, sizeof(quadVertices));
+    memcpy(t, quadTexCoords, sizeof(quadTexCoords));
+  }
+
+  texture.bind();
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+  glVertexPointer(2, GL_FLOAT, 0, &vertices[0]);
+  glTexCoordPointer(2, GL_FLOAT, 0, &texCoords[0]);
+  glDrawArrays(GL_TRIANGLES, 0, count * 6);
+  glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+  glDisableClientState(GL_VERTEX_ARRAY);
+  texture.unbind();
+}
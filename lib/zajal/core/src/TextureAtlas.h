@@ -0,0 +1,48 @@
+#ifndef _TextureAtlas_h_header
+#define _TextureAtlas_h_header
+
+#include "ofMain.h"
+
+// Packs many small images into a few large pages
+// 
+// Packing uses a bottom-left skyline: the top edge of everything placed so
+// far is kept as a list of horizontal segments, and each rectangle goes
+// wherever it ends up lowest. Rectangles are placed tallest first, and a new
+// page is started whenever one doesn't fit on any open page.
+class TextureAtlas {
+public:
+  TextureAtlas();
+
+  void setup(int pageWidth, int pageHeight, int padding);
+
+  // rects holds count records of 5 ints: width, height, page, x, y. Width
+  // and height are read, page, x and y are written. A rectangle too big for
+  // a page gets page -1. Returns the number of pages used.
+  int pack(int* rects, int count);
+
+  // Allocate page as a transparent pageWidth*pageHeight RGBA image
+  void allocate(ofImage& page);
+
+  // Copy sprite's pixels into page at (x, y), converting channel counts
+  void blit(ofImage& page, ofPixels& sprite, int x, int y);
+
+  int pageWidth;
+  int pageHeight;
+  int padding;
+};
+
+// Draws many regions of one atlas page with a single texture bind and a
+// single draw call
+class SpriteBatch {
+public:
+  SpriteBatch();
+
+  // quads holds count records of 8 floats: the source rectangle on the page
+  // (sx, sy, sw, sh) followed by the destination rectangle (dx, dy, dw, dh)
+  void draw(ofImage& page, float* quads, int count);
+
+  vector<float> vertices;
+  vector<float> texCoords;
+};
+
+#endif /* _TextureAtlas_h_header */
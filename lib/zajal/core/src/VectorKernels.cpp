@@ -0,0 +1,174 @@
+#include "VectorKernels.h"
+#include "Parallel.h"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// vectors per thread below which per vector kernels stay on one thread
+#define VECTOR_MIN_PER_JOB 32768
+
+// a broadcast vector repeated to 12 floats lines up with any component
+// count from 1 to 4, and with 4 float lanes
+#define VECTOR_PATTERN 12
+
+static inline float combine(int op, float a, float b) {
+  switch(op) {
+    case VECTOR_ADD:      return a + b;
+    case VECTOR_SUBTRACT: return a - b;
+    case VECTOR_MULTIPLY: return a * b;
+    default:              return a / b;
+  }
+}
+
+#if defined(__SSE2__)
+static inline __m128 combine4(int op, __m128 a, __m128 b) {
+  switch(op) {
+    case VECTOR_ADD:      return _mm_add_ps(a, b);
+    case VECTOR_SUBTRACT: return _mm_sub_ps(a, b);
+    case VECTOR_MULTIPLY: return _mm_mul_ps(a, b);
+    default:              return _mm_div_ps(a, b);
+  }
+}
+#endif
+
+void vectorsApply(int op, float* values, float* other, int count, int components, bool broadcast) {
+  if(count <= 0 || components < 1 || components > 4) return;
+  int n = count * components;
+  int i = 0;
+
+  if(!broadcast) {
+#if defined(__SSE2__)
+    for(; i + 4 <= n; i += 4)
+      _mm_storeu_ps(values + i, combine4(op, _mm_loadu_ps(values + i), _mm_loadu_ps(other + i)));
+#endif
+    for(; i < n; i++)
+      values[i] = combine(op, values[i], other[i]);
+    return;
+  }
+
+  float pattern[VECTOR_PATTERN];
+  for(int k = 0; k < VECTOR_PATTERN; k++)
+    pattern[k] = other[k % components];
+
+#if defined(__SSE2__)
+  __m128 p0 = _mm_loadu_ps(pattern), p1 = _mm_loadu_ps(pattern + 4), p2 = _mm_loadu_ps(pattern + 8);
+  for(; i + VECTOR_PATTERN <= n; i += VECTOR_PATTERN) {
+    _mm_storeu_ps(values + i,     combine4(op, _mm_loadu_ps(values + i), p0));
+    _mm_storeu_ps(values + i + 4, combine4(op, _mm_loadu_ps(values + i + 4), p1));
+    _mm_storeu_ps(values + i + 8, combine4(op, _mm_loadu_ps(values + i + 8), p2));
+  }
+#endif
+  for(; i < n; i++)
+    values[i] = combine(op, values[i], pattern[i % VECTOR_PATTERN]);
+}
+
+void vectorsScale(float* values, int count, int components, float k) {
+  int n = count * components;
+  int i = 0;
+#if defined(__SSE2__)
+  __m128 k4 = _mm_set1_ps(k);
+  for(; i + 4 <= n; i += 4)
+    _mm_storeu_ps(values + i, _mm_mul_ps(_mm_loadu_ps(values + i), k4));
+#endif
+  for(; i < n; i++)
+    values[i] *= k;
+}
+
+static inline float lengthSquared(const float* v, int components) {
+  float sum = 0.0f;
+  for(int c = 0; c < components; c++)
+    sum += v[c] * v[c];
+  return sum;
+}
+
+struct VectorJob {
+  float* out;
+  float* values;
+  float* other;
+  int components;
+};
+
+static void normalizeRange(void* context, int begin, int end) {
+  VectorJob* job = (VectorJob*)context;
+  for(int i = begin; i < end; i++) {
+    float* v = job->values + i * job->components;
+    float length2 = lengthSquared(v, job->components);
+    if(length2 == 0.0f) continue;
+
+    float k = 1.0f / sqrtf(length2);
+    for(int c = 0; c < job->components; c++)
+      v[c] *= k;
+  }
+}
+
+void vectorsNormalize(float* values, int count, int components) {
+  if(count <= 0 || components < 1 || components > 4) return;
+
+  VectorJob job = { NULL, values, NULL, components };
+  parallelBands(count, VECTOR_MIN_PER_JOB, normalizeRange, &job);
+}
+
+void vectorsLengths(float* out, float* values, int count, int components) {
+  for(int i = 0; i < count; i++)
+    out[i] = sqrtf(lengthSquared(values + i * components, components));
+}
+
+void vectorsDot(float* out, float* values, float* other, int count, int components) {
+  for(int i = 0; i < count; i++) {
+    const float* a = values + i * components;
+    const float* b = other + i * components;
+    float sum = 0.0f;
+    for(int c = 0; c < components; c++)
+      sum += a[c] * b[c];
+    out[i] = sum;
+  }
+}
+
+// other holds the matrix
+static void transformRange(void* context, int begin, int end) {
+  VectorJob* job = (VectorJob*)context;
+  const float* m = job->other;
+  int components = job->components;
+
+  for(int i = begin; i < end; i++) {
+    float* v = job->values + i * components;
+    float x = v[0], y = v[1], z = components > 2 ? v[2] : 0.0f;
+    v[0] = x * m[0] + y * m[4] + z * m[8]  + m[12];
+    v[1] = x * m[1] + y * m[5] + z * m[9]  + m[13];
+    if(components > 2)
+      v[2] = x * m[2] + y * m[6] + z * m[10] + m[14];
+  }
+}
+
+void vectorsTransform(float* values, int count, int components, float* matrix) {
+  if(count <= 0 || components < 2 || components > 3) return;
+
+  VectorJob job = { NULL, values, matrix, components };
+  parallelBands(count, VECTOR_MIN_PER_JOB, transformRange, &job);
+}
+
+void matrixMultiply(float* out, float* a, float* b) {
+  float result[16];
+
+  for(int row = 0; row < 4; row++) {
+#if defined(__SSE2__)
+    __m128 sum = _mm_mul_ps(_mm_set1_ps(a[row * 4]), _mm_loadu_ps(b));
+    for(int k = 1; k < 4; k++)
+      sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(a[row * 4 + k]), _mm_loadu_ps(b + k * 4)));
+    _mm_storeu_ps(result + row * 4, sum);
+#else
+    for(int col = 0; col < 4; col++) {
+      float sum = 0.0f;
+      for(int k = 0; k < 4; k++)
+        sum += a[row * 4 + k] * b[k * 4 + col];
+      result[row * 4 + col] = sum;
+    }
+#endif
+  }
+
+  memcpy(out, result, sizeof(result));
+}
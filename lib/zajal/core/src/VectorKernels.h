@@ -0,0 +1,42 @@
+#ifndef _VectorKernels_h_header
+#define _VectorKernels_h_header
+
+// Arithmetic over packed arrays of small vectors
+//
+// values holds count vectors of components (1 to 4) floats each, one after
+// the other, and is changed in place. Flat loops use SSE2, and the heavier
+// per vector kernels split big arrays across worker threads (see
+// Parallel.h).
+
+enum VectorOp {
+  VECTOR_ADD,
+  VECTOR_SUBTRACT,
+  VECTOR_MULTIPLY,
+  VECTOR_DIVIDE
+};
+
+// Combine each vector in values with the matching one in other, component
+// by component. With broadcast, other is a single vector combined with
+// every vector in values.
+void vectorsApply(int op, float* values, float* other, int count, int components, bool broadcast);
+
+void vectorsScale(float* values, int count, int components, float k);
+
+// Scale every vector to length 1, leaving zero vectors alone
+void vectorsNormalize(float* values, int count, int components);
+
+// Write the length of each vector into out
+void vectorsLengths(float* out, float* values, int count, int components);
+
+// Write the dot product of each pair of vectors into out
+void vectorsDot(float* out, float* values, float* other, int count, int components);
+
+// Transform 2 or 3 component points by matrix, 16 floats laid out like
+// ofMatrix4x4. Points are row vectors with w = 1, as openFrameworks uses
+// them, and w is dropped afterwards.
+void vectorsTransform(float* values, int count, int components, float* matrix);
+
+// out = a * b, all laid out like ofMatrix4x4. out may be a or b.
+void matrixMultiply(float* out, float* a, float* b);
+
+#endif /* _VectorKernels_h_header */
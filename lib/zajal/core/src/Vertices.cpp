@@ -0,0 +1,10 @@
+#include "Vertices.h"
+
+void drawVertices(float* vertices, int count, int dimensions, int mode) {
+  if(count <= 0 || dimensions < 2 || dimensions > 3) return;
+
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glVertexPointer(dimensions, GL_FLOAT, 0, vertices);
+  glDrawArrays(mode, 0, count);
+  glDisableClientState(GL_VERTEX_ARRAY);
+}
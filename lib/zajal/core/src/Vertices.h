@@ -0,0 +1,11 @@
+#ifndef _Vertices_h_header
+#define _Vertices_h_header
+
+#include "ofMain.h"
+
+// Draw count vertices of dimensions (2 or 3) floats each, packed one after
+// the other, as primitives of mode (GL_POINTS, GL_LINES, ...) with a single
+// draw call
+void drawVertices(float* vertices, int count, int dimensions, int mode);
+
+#endif /* _Vertices_h_header */
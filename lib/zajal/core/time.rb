@@ -1,7 +1,25 @@
 module Zajal
+  # Time as the sketch sees it
+  #
+  # The frontend stamps the time once as each frame starts (see
+  # frontends/FrameTime.h), and {#time}, {#milliseconds}, {#microseconds},
+  # {#frame} and {#delta_time} all read that stamp. Asking for the time
+  # costs no clock calls, and everything drawn in a frame agrees on when
+  # it is. Use {#now} for the actual current time, e.g. to measure how
+  # long something takes.
   module Time
+    class << self
+      # @api internal
+      # @return [FFI::Pointer] the frontend's FrameTime, or nil to ask the
+      #   clock every time
+      attr_accessor :frame_time
+    end
+
+    # @return [Float] seconds since the sketch started, as of the start of
+    #   this frame
     def time
-      Native.ofGetElapsedTimef
+      stamp = Time.frame_time
+      stamp ? stamp.get_float64(0) : Native.ofGetElapsedTimef
     end
 
     def seconds
@@ -9,21 +27,37 @@ module Zajal
     end
 
     def milliseconds
-      Native.ofGetElapsedTimeMillis
+      stamp = Time.frame_time
+      stamp ? (stamp.get_float64(0) * 1000).to_i : Native.ofGetElapsedTimeMillis
     end
 
     def microseconds
-      Native.ofGetElapsedTimeMicros
+      stamp = Time.frame_time
+      stamp ? (stamp.get_float64(0) * 1000000).to_i : Native.ofGetElapsedTimeMicros
+    end
+
+    # @return [Float] seconds between the start of the last frame and the
+    #   start of this one
+    def delta_time
+      stamp = Time.frame_time
+      stamp ? stamp.get_float64(8) : 0.0
     end
 
     def frame
-      Native.ofGetFrameNum
+      stamp = Time.frame_time
+      stamp ? stamp.get_int32(16) : Native.ofGetFrameNum
+    end
+
+    # @return [Float] seconds since the sketch started, right now
+    def now
+      Native.ofGetElapsedTimeMicros / 1000000.0
     end
 
     module Native
       extend FFI::Cpp::Library
 
       File.expand_path("lib/libof.so", File.dirname(__FILE__))
+      bind_lazily
 
       attach_function :ofResetElapsedTimeCounter, [], :void
       attach_function :ofGetElapsedTimef, [], :float
@@ -32,4 +66,4 @@ module Zajal
       attach_function :ofGetFrameNum, [], :int
     end
   end
-end
\ No newline at end of file
+end
@@ -6,6 +6,10 @@ module Zajal
   module Typography
     # A font
     class Font
+      # Fonts outlive reloads of the sketch, and a reloaded sketch asking
+      # for the same font gets it back without loading it again, see
+      # {Zajal::Resources}.
+      # 
       # @param file [#to_s] the file to load
       # @param size [Numeric] the size of the font
       # @param options [Hash] additional options
@@ -34,8 +38,11 @@ module Zajal
           next unless File.exists? f
 
           @name = File.basename(f)
-          @pointer = Native.oftruetypefont_new
-          Native.oftruetypefont_loadFont @pointer, f.to_s.to_ptr, size.to_i, options[:antialiased].to_bool, options[:full_character_set].to_bool, options[:contours].to_bool, options[:simplify].to_f, options[:dpi].to_i
+          @pointer = Resources.fetch(:font, f, File.mtime(f), size.to_i, options) do
+            pointer = Native.oftruetypefont_new
+            Native.oftruetypefont_loadFont pointer, f.to_s.to_ptr, size.to_i, options[:antialiased].to_bool, options[:full_character_set].to_bool, options[:contours].to_bool, options[:simplify].to_f, options[:dpi].to_i
+            pointer
+          end
           break
         end
 
@@ -128,8 +135,10 @@ module Zajal
       extend FFI::Cpp::Library
       
       File.expand_path("lib/libof.so", File.dirname(__FILE__))
+      bind_lazily
 
       attach_constructor :ofTrueTypeFont, 344, []
+      attach_destructor :ofTrueTypeFont
       attach_method :ofTrueTypeFont, :drawString, [:stdstring, :float, :float], :void
       attach_method :ofTrueTypeFont, :loadFont, [:stdstring, :int, :bool, :bool, :bool, :float, :int], :void
       attach_method :ofTrueTypeFont, :getSize, [], :int
@@ -0,0 +1,244 @@
+module Zajal
+  # Common ground of {Vec2} and {Vec3}
+  #
+  # Vectors keep their components in native memory, laid out like
+  # openFrameworks' ofVec3f. Graphics methods recognise them by class and
+  # hand them to openFrameworks by pointer, skipping the signature matching
+  # and unpacking other point objects go through. A {Vec2} keeps a zero z,
+  # so it can be passed the same way.
+  #
+  # For many vectors at once, use a {Buffer} with 2 or 3 components, whose
+  # bulk arithmetic runs natively.
+  #
+  # @api zajal
+  class Vector
+    def initialize *components
+      @pointer = FFI::MemoryPointer.new :float, 3
+      @pointer.put_array_of_float 0, components.map(&:to_f)
+    end
+
+    # @return [Array<Float>] the components
+    def to_a
+      @pointer.get_array_of_float 0, self.class::Size
+    end
+
+    def [] i
+      to_a[i]
+    end
+
+    def + other
+      self.class.new *to_a.zip(components_of(other)).map { |a, b| a + b }
+    end
+
+    def - other
+      self.class.new *to_a.zip(components_of(other)).map { |a, b| a - b }
+    end
+
+    # Multiply by a number, or component by component by another vector
+    def * other
+      self.class.new *to_a.zip(components_of(other)).map { |a, b| a * b }
+    end
+
+    # Divide by a number, or component by component by another vector
+    def / other
+      self.class.new *to_a.zip(components_of(other)).map { |a, b| a / b }
+    end
+
+    def -@
+      self * -1
+    end
+
+    def dot other
+      to_a.zip(other.to_a).inject(0.0) { |sum, (a, b)| sum + a * b }
+    end
+
+    def length_squared
+      dot self
+    end
+
+    def length
+      Math.sqrt length_squared
+    end
+
+    def == other
+      other.class == self.class and other.to_a == to_a
+    end
+
+    def distance other
+      (self - other).length
+    end
+
+    # @return [Vector] a vector in the same direction with length 1
+    def normalize
+      l = length
+      l.zero? ? self.class.new(*to_a) : self / l
+    end
+
+    # The vector +amount+ of the way from this one to +other+
+    def lerp other, amount
+      self + (other - self) * amount
+    end
+
+    def to_s
+      "#{self.class.name.split('::').last}(#{to_a.join(', ')})"
+    end
+    alias :inspect :to_s
+
+    # @api internal
+    def to_ptr
+      @pointer
+    end
+
+    private
+
+    def components_of other
+      other.is_a?(Numeric) ? [other.to_f] * self.class::Size : other.to_a
+    end
+  end
+
+  # A two dimensional vector
+  #
+  # @example
+  #   position = Vec2.new 10, 20
+  #   velocity = Vec2.new 1, 0.5
+  #   position += velocity * 2
+  #   circle position, 5
+  class Vec2 < Vector
+    Size = 2
+
+    def initialize x=0, y=0
+      super x, y
+    end
+
+    def x; @pointer.get_float32 0 end
+    def y; @pointer.get_float32 4 end
+
+    def x= v; @pointer.put_float32 0, v.to_f end
+    def y= v; @pointer.put_float32 4, v.to_f end
+  end
+
+  # A three dimensional vector
+  class Vec3 < Vector
+    Size = 3
+
+    def initialize x=0, y=0, z=0
+      super x, y, z
+    end
+
+    def x; @pointer.get_float32 0 end
+    def y; @pointer.get_float32 4 end
+    def z; @pointer.get_float32 8 end
+
+    def x= v; @pointer.put_float32 0, v.to_f end
+    def y= v; @pointer.put_float32 4, v.to_f end
+    def z= v; @pointer.put_float32 8, v.to_f end
+
+    def cross other
+      ax, ay, az = to_a
+      bx, by, bz = other.to_a
+      Vec3.new ay * bz - az * by, az * bx - ax * bz, ax * by - ay * bx
+    end
+  end
+
+  # A 4x4 transformation matrix
+  #
+  # Laid out like openFrameworks' ofMatrix4x4, which treats points as row
+  # vectors: +a * b+ transforms by +a+ first, then by +b+.
+  #
+  # @example Spin around a point
+  #   m = Mat4.translation(-50, -50) * Mat4.rotation(time * 90) * Mat4.translation(50, 50)
+  #   multiply_matrix m
+  #   square 40, 40, 20
+  #
+  # @api zajal
+  class Mat4
+    Identity = [1, 0, 0, 0,
+                0, 1, 0, 0,
+                0, 0, 1, 0,
+                0, 0, 0, 1]
+
+    # @overload new
+    #   The identity matrix
+    # @overload new *values
+    #   @param values [Array<Numeric>] 16 values, row by row
+    def initialize *values
+      values = Identity if values.empty?
+      raise ArgumentError, "a Mat4 needs 16 values" unless values.size == 16
+
+      @pointer = FFI::MemoryPointer.new :float, 16
+      @pointer.put_array_of_float 0, values.map(&:to_f)
+    end
+
+    def self.translation x, y, z=0
+      new 1, 0, 0, 0,  0, 1, 0, 0,  0, 0, 1, 0,  x, y, z, 1
+    end
+
+    def self.scaling x, y=nil, z=1
+      y ||= x
+      new x, 0, 0, 0,  0, y, 0, 0,  0, 0, z, 0,  0, 0, 0, 1
+    end
+
+    # Rotation by +degrees+ around an axis, z by default
+    def self.rotation degrees, x=0, y=0, z=1
+      l = Math.sqrt(x * x + y * y + z * z)
+      x, y, z = x / l.to_f, y / l.to_f, z / l.to_f
+      r = degrees * Math::PI / 180
+      c, s, t = Math.cos(r), Math.sin(r), 1 - Math.cos(r)
+
+      new t*x*x + c,   t*x*y + s*z, t*x*z - s*y, 0,
+          t*x*y - s*z, t*y*y + c,   t*y*z + s*x, 0,
+          t*x*z + s*y, t*y*z - s*x, t*z*z + c,   0,
+          0,           0,           0,           1
+    end
+
+    # @return [Array<Float>] 16 values, row by row
+    def to_a
+      @pointer.get_array_of_float 0, 16
+    end
+
+    def [] row, column
+      @pointer.get_float32 (row * 4 + column) * 4
+    end
+
+    def []= row, column, value
+      @pointer.put_float32 (row * 4 + column) * 4, value.to_f
+    end
+
+    # @overload * matrix
+    #   @return [Mat4] transform by this matrix, then by +matrix+
+    # @overload * vector
+    #   @return [Vec2, Vec3] +vector+ transformed by this matrix
+    def * other
+      case other
+      when Mat4
+        product = Mat4.new
+        Buffer::Native.matrixMultiply product.to_ptr, @pointer, other.to_ptr
+        product
+      when Vector
+        transformed = other.class.new *other.to_a
+        Buffer::Native.vectorsTransform transformed.to_ptr, 1, other.class::Size, @pointer
+        transformed
+      else
+        raise ArgumentError, "can't multiply a Mat4 by #{other.inspect}"
+      end
+    end
+
+    def transpose
+      Mat4.new *to_a.each_slice(4).to_a.transpose.flatten
+    end
+
+    def == other
+      other.is_a? Mat4 and other.to_a == to_a
+    end
+
+    def to_s
+      "Mat4(#{to_a.each_slice(4).map { |row| row.join(', ') }.join('; ')})"
+    end
+    alias :inspect :to_s
+
+    # @api internal
+    def to_ptr
+      @pointer
+    end
+  end
+end
@@ -1,2 +1,4 @@
 require "zajal/ffipp/ffipp"
-require "zajal/ffipp/libstdcpp"
\ No newline at end of file
+require "zajal/ffipp/symbols"
+require "zajal/ffipp/profiler"
+require "zajal/ffipp/libstdcpp"
@@ -1,3 +1,5 @@
+require "thread"
+
 module FFI
 # FFI extension to allow calling into C++ code.
 # 
@@ -7,8 +9,8 @@ module FFI
 # clunky C shims or generated wrappers. The goal is to be able to use
 # unmodified C++ shared objects as if they were written in C.
 # 
-# It supports normal functions, instance methods, and class construtcors.
-# Still missing are class destructors, templates, std::strings, and others.
+# It supports normal functions, instance methods, and class construtcors and
+# destructors. Still missing are templates, std::strings, and others.
 # GCC 4.x only at the moment.
   module Cpp
     # Contains manglers for different compiler/versions
@@ -191,11 +193,161 @@ module FFI
       end
     end
 
+    # A C++ object constructed by FFIPP, owned by Ruby
+    # 
+    # Runs the object's destructor when {#free} is called, or when it is
+    # garbage collected otherwise, then frees its memory, and counts how
+    # many objects of each class are alive, so leaks show up in {.live}.
+    # Returned by the +_new+ methods of classes with a destructor attached.
+    # 
+    # The object lives in memory from {.malloc} rather than an
+    # FFI::MemoryPointer, which FFI won't let an AutoPointer wrap, and
+    # which could be freed before the destructor has run.
+    # 
+    # Finalizers can run on any thread, but destructors like ofFbo's need
+    # the thread with the GL context. So a collected object's destructor is
+    # only queued, and runs when the frontend calls {.release_pending} at
+    # the end of the frame. {#free} still destroys right away.
+    # 
+    # @see Library#attach_destructor
+    class Owned < FFI::AutoPointer
+      # calloc and free, for memory only Owned frees
+      # 
+      # @api internal
+      module Heap
+        extend FFI::Library
+        ffi_lib FFI::Library::LIBC
+
+        attach_function :calloc, [:size_t, :size_t], :pointer
+        attach_function :free, [:pointer], :void
+      end
+
+      @live = Hash.new(0)
+      @pending = Queue.new
+
+      # @return [Hash{Symbol => Fixnum}] how many objects of each class
+      #   are alive, including collected ones still waiting for
+      #   {.release_pending}
+      def self.live
+        @live.reject { |klass, count| count.zero? }
+      end
+
+      # Zeroed memory for an object to be constructed into and then owned
+      # 
+      # @param size [Fixnum] size in pointers, like {Library#attach_constructor}'s
+      # @return [FFI::Pointer]
+      def self.malloc size
+        memory = Heap.calloc size, FFI.type_size(:pointer)
+        raise NoMemoryError, "failed to allocate #{size} pointers" if memory.null?
+        memory
+      end
+
+      # @param memory [FFI::Pointer] the constructed object, in memory from
+      #   {.malloc}, which is freed along with it
+      # @param klass [Symbol] the object's class, for counting
+      # @param destructor [#call] the class' destructor
+      def initialize memory, klass, destructor
+        Owned.count klass, 1
+        super memory, Owned.releaser(memory, klass, destructor)
+      end
+
+      # Destroy the object now, on this thread
+      def free
+        Thread.current[:ffipp_freeing] = true
+        super
+      ensure
+        Thread.current[:ffipp_freeing] = false
+      end
+
+      # Run the destructors of objects collected since the last call. Call
+      # on the thread the objects belong to.
+      def self.release_pending
+        # the frontend is the only one popping, so pop never waits
+        destroy(*@pending.pop) until @pending.empty?
+      end
+
+      # Built out here rather than in #initialize, so the releaser doesn't
+      # hold on to the Owned and keep it from being collected.
+      # 
+      # @api internal
+      def self.releaser memory, klass, destructor
+        pending = @pending
+        lambda do |pointer|
+          if Thread.current[:ffipp_freeing]
+            destroy destructor, memory, klass
+          else
+            pending.push [destructor, memory, klass]
+          end
+        end
+      end
+
+      # @api internal
+      def self.destroy destructor, memory, klass
+        destructor.call memory
+      ensure
+        Heap.free memory
+        count klass, -1
+      end
+
+      # @api internal
+      def self.count klass, change
+        @live[klass] += change
+      end
+    end
+
+    # Open a shared object into the process once, so its symbols are there
+    # for everything loaded after it
+    # 
+    # @param path [String]
+    def self.open_library path
+      @opened ||= {}
+      @opened[path] ||= FFI::DynamicLibrary.open_library path, FFI::DynamicLibrary::RTLD_LAZY | FFI::DynamicLibrary::RTLD_GLOBAL
+    end
+
+    # Open a shared object only once a function can't be attached without
+    # it, rather than now, for libraries few sketches use
+    # 
+    # @param path [String]
+    def self.defer_library path
+      (@deferred_libraries ||= []) << path
+    end
+
+    # Open the libraries left for later by {.defer_library}
+    # 
+    # @return [Boolean] were there any?
+    def self.open_deferred_libraries
+      deferred, @deferred_libraries = @deferred_libraries || [], []
+      deferred.each { |path| open_library path }
+      not deferred.empty?
+    end
+
     # C++ Library support
     module Library
       include FFI::Library
       include FFI::Cpp::Manglers::GCC4X # TODO implement system to select correct mangler
 
+      class << self
+        # @return [Boolean] ignore {#bind_lazily} and attach everything as
+        #   it's declared, to find missing symbols at startup
+        attr_accessor :eager
+      end
+
+      # How a function was attached. Methods, constructors and destructors
+      # have +klass+, and their first parameter is the instance.
+      Declaration = ::Struct.new(:name, :params, :returns, :klass)
+
+      # @return [Hash{Symbol => Fixnum}] sizes in pointers of the classes
+      #   constructors were attached for
+      def object_sizes
+        @object_sizes ||= {}
+      end
+
+      # @return [Hash{Symbol => Declaration}] everything attached with FFIPP,
+      #   by Ruby name, for tools that call bindings generically
+      def declarations
+        @declarations ||= {}
+      end
+
       def type t
         MangledType.new(t)
       end
@@ -203,6 +355,58 @@ module FFI
       # support cpp linkage in attach_function
       alias :attach_c_function :attach_function
 
+      # Libraries to attach to, and their symbols
+      def ffi_lib *names
+        @symbol_table = names.size == 1 ? SymbolTable.for(names.first) : nil
+        super
+      end
+
+      # @return [SymbolTable, nil] the symbols of the library functions are
+      #   attached from, the process' own if there was no +ffi_lib+
+      def symbol_table
+        defined?(@symbol_table) ? @symbol_table : SymbolTable.default
+      end
+
+      # Attach functions declared from here on the first time they're called
+      # 
+      # Declaring one just defines a stand-in, which attaches the function
+      # over itself and passes the call on, so functions a sketch never
+      # calls cost nothing at startup. Functions are attached from the
+      # libraries current when they're first called, so only use this in
+      # modules that call +ffi_lib+ once, before it. Missing symbols raise
+      # on the first call instead of at load.
+      def bind_lazily
+        @lazy = true unless Library.eager
+      end
+
+      # @api internal
+      def declare rbname, params, returns, klass=nil
+        Profiler.wrap self, rbname if Profiler.enabled
+        declarations[rbname.to_sym] = Declaration.new(rbname.to_sym, params.map { |p| p.to_sym }, returns, klass && klass.to_sym)
+      end
+
+      # @api internal
+      # Run +attach+ now, or when +rbname+ is first called if binding lazily
+      def bind rbname, &attach
+        return attach.call unless @lazy
+
+        rbname = rbname.to_sym
+        deferred = (@deferred ||= {})
+        deferred[rbname] = attach
+
+        singleton_class.send :define_method, rbname do |*args, &block|
+          # stand-ins captured with #method get here after attaching too.
+          # If attaching raises, it's tried again, and raises again, next
+          # call.
+          pending = deferred[rbname]
+          if pending
+            pending.call
+            deferred.delete rbname
+          end
+          send rbname, *args, &block
+        end
+      end
+
       # Attatch top level C/C++ function to this module
       # 
       # @overload attach_function name, params, returns, options={}
@@ -220,17 +424,45 @@ module FFI
           cname = rbname
         end
 
-        begin
-          # try c linkage
-          attach_c_function rbname, cname, params, returns
+        declare rbname, params, returns
+        bind(rbname) { resolve_function rbname, cname, params, returns }
+      end
+
+      # @api internal
+      def resolve_function rbname, cname, params, returns
+        symbols = symbol_table
+        if symbols and symbols.include? cname
+          attach_c_function rbname, cname, params.map { |p| p.to_sym }, returns
 
-        rescue FFI::NotFoundError
-          # try cpp linkage
-          mangled_name = mangle_function cname, params
+        elsif symbols and symbols.include?(mangled_name = mangle_function(cname, params))
           attach_c_function rbname, mangled_name, params.map { |p| p.to_sym }, returns
+
+        else
+          # not in the table, e.g. it lives in another library
+          with_deferred_libraries do
+            begin
+              # try c linkage
+              attach_c_function rbname, cname, params, returns
+
+            rescue FFI::NotFoundError
+              # try cpp linkage
+              mangled_name = mangle_function cname, params
+              attach_c_function rbname, mangled_name, params.map { |p| p.to_sym }, returns
+            end
+          end
         end
       end
 
+      # @api internal
+      # Run +attach+, and once more after opening the libraries deferred
+      # with {FFI::Cpp.defer_library} if it can't find its symbol
+      def with_deferred_libraries &attach
+        attach.call
+      rescue FFI::NotFoundError
+        raise unless FFI::Cpp.open_deferred_libraries
+        attach.call
+      end
+
       # Attatch constructor for class +klass+ to module
       # 
       # @example
@@ -240,8 +472,12 @@ module FFI
       def attach_constructor klass, size, params, mangled_name=nil
         mangled_name ||= mangle_method klass, :ctor, params
         implicit_params = [:pointer] + params
+        object_sizes[klass.to_sym] = size
 
-        attach_c_function "#{klass.to_sym.downcase}_ctor", mangled_name, implicit_params.map { |p| p.to_sym }, :void
+        declare "#{klass.to_sym.downcase}_ctor", implicit_params, :void, klass
+        bind("#{klass.to_sym.downcase}_ctor") do
+          with_deferred_libraries { attach_c_function "#{klass.to_sym.downcase}_ctor", mangled_name, implicit_params.map { |p| p.to_sym }, :void }
+        end
 
         self.module_eval <<-code
           def self.#{klass.to_sym.downcase}_alloc
@@ -256,11 +492,48 @@ module FFI
         code
       end
 
+      # Attatch destructor for class +klass+ to module
+      # 
+      # From then on the class' +_new+ method returns an {Owned} pointer,
+      # which destroys the object when freed or garbage collected, so this
+      # has to follow {#attach_constructor}.
+      # 
+      # @example
+      #   module Native
+      #     attach_constructor :Widget, 682, [:float, :float, :int]
+      #     attach_destructor :Widget
+      #   end
+      def attach_destructor klass, mangled_name=nil
+        mangled_name ||= mangle_method klass, :dtor, []
+        size = object_sizes.fetch(klass.to_sym) { raise ArgumentError, "attach_constructor :#{klass} before its destructor" }
+
+        declare "#{klass.to_sym.downcase}_dtor", [:pointer], :void, klass
+        bind("#{klass.to_sym.downcase}_dtor") do
+          with_deferred_libraries { attach_c_function "#{klass.to_sym.downcase}_dtor", mangled_name, [:pointer], :void }
+        end
+
+        self.module_eval <<-code
+          def self.#{klass.to_sym.downcase}_new *args
+            instance = FFI::Cpp::Owned.malloc #{size}
+            begin
+              #{klass.to_sym.downcase}_ctor(instance, *args)
+            rescue Exception
+              FFI::Cpp::Owned::Heap.free instance
+              raise
+            end
+            FFI::Cpp::Owned.new instance, :#{klass.to_sym}, method(:#{klass.to_sym.downcase}_dtor)
+          end
+        code
+      end
+
       def attach_method klass, name, params, returns, mangled_name=nil
         mangled_name ||= mangle_method klass, name, params
         implicit_params = [:pointer] + params
 
-        attach_c_function "#{klass.to_sym.downcase}_#{name}", mangled_name, implicit_params.map { |p| p.to_sym }, returns
+        declare "#{klass.to_sym.downcase}_#{name}", implicit_params, returns, klass
+        bind("#{klass.to_sym.downcase}_#{name}") do
+          with_deferred_libraries { attach_c_function "#{klass.to_sym.downcase}_#{name}", mangled_name, implicit_params.map { |p| p.to_sym }, returns }
+        end
       end
     end
   end
@@ -1,4 +1,18 @@
 module FFI::Cpp
+  # std::strings for Ruby strings, made without allocating in steady state
+  #
+  # Strings are copied into std::strings from a per-frame arena, which the
+  # frontend resets at the end of every frame with {.reset_arena}. Arena
+  # strings keep their capacity between frames, so text drawn every frame
+  # allocates nothing once the arena has warmed up. An arena string is
+  # good until the end of the frame, and never handed out twice within
+  # one, so the function it's passed to may change it.
+  #
+  # Frozen strings passed as a const std::string& can be interned instead:
+  # each distinct one gets a std::string that is kept and passed every
+  # time. Only for const references, since anything else lets the callee
+  # change the one copy every later call shares. Parameters declared as a
+  # plain +:stdstring+ are passed by value, which the callee may change.
   module Std
     extend FFI::Cpp::Library
 
@@ -6,17 +20,80 @@ module FFI::Cpp
     # _Z         N      Ss          C1          E        PKc         RKSa                 Ic     E
     # Start name Nested std::string Constructor End name const char* const &std::allocator<char> End all
     attach_constructor :string, 8, [:string, :pointer], :_ZNSsC1EPKcRKSaIcE
+    attach_destructor :string, :_ZNSsD1Ev
+    attach_method :string, :assign, [:string, :size_t], :pointer, :_ZNSs6assignEPKcm
+
+    # Most distinct frozen strings interned, later ones go through the arena
+    InternLimit = 1024
+
+    # Most arena strings handed out in a frame. The arena grows to what the
+    # busiest frame needs, but a string handed out earlier in the frame may
+    # still be held, so rather than reuse one past this, {.transient}
+    # raises. Hitting it means the arena isn't being reset.
+    ArenaLimit = 65_536
+
+    @interned = {}
+    @arena = []
+    @arena_used = 0
+
+    # @param str [String] a frozen string, only to be passed as a const
+    #   std::string&
+    # @return [FFI::Pointer] a std::string kept for as long as Zajal runs
+    def self.intern str
+      interned = @interned[str]
+      return interned if interned
+      return transient(str) if @interned.size >= InternLimit
+
+      @interned[str] = assign string_new("", nil), str
+    end
+
+    # @param str [String]
+    # @return [FFI::Pointer] a std::string good until the end of the frame
+    # @raise [IndexError] if more than {ArenaLimit} were handed out this
+    #   frame
+    def self.transient str
+      if @arena_used == @arena.size
+        raise IndexError, "more than #{ArenaLimit} std::strings in one frame, is Std.reset_arena being called?" if @arena.size >= ArenaLimit
+        @arena << string_new("", nil)
+      end
+
+      @arena_used += 1
+      assign @arena[@arena_used - 1], str
+    end
+
+    # Hand the arena's strings out again from the start
+    def self.reset_arena
+      @arena_used = 0
+    end
+
+    # @api internal
+    def self.assign string, str
+      string_assign string, str, str.bytesize
+      string
+    end
   end
 end
 
 class String
+  # @return [FFI::Pointer] a std::string good until the end of the frame,
+  #   for a +:stdstring+ parameter
+  # 
   # @todo Should this be in a separate class, i.e. FFI::Cpp::Std::String?
   # @note #to_ptr won't be called by FFI automatically because NativeFunction::call
   #   checks for String type before it checks responses to #to_ptr, and will try
-  #   to pass the string as a c-string. 
-  # 
+  #   to pass the string as a c-string.
+  #
   # @see https://github.com/rubinius/rubinius/blob/master/vm/builtin/nativefunction.cpp
+  # @see FFI::Cpp::Std
   def to_ptr
-    FFI::Cpp::Std::string_new self, nil
+    FFI::Cpp::Std.transient self
   end
-end
\ No newline at end of file
+
+  # @return [FFI::Pointer] a std::string for a const std::string&
+  #   parameter, interned if this string is frozen
+  # 
+  # @see FFI::Cpp::Std.intern
+  def to_const_ref
+    frozen? ? FFI::Cpp::Std.intern(self) : FFI::Cpp::Std.transient(self)
+  end
+end
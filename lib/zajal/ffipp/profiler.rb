@@ -0,0 +1,92 @@
+module FFI
+  module Cpp
+    # Counts calls to bindings and the time spent in them, frame by frame
+    #
+    # Off unless turned on before bindings are declared. Every binding
+    # declared from then on counts its calls and times them, including the
+    # cost of crossing into C, until the frontend calls {.frame} at the end
+    # of a frame. {.report} lists the busiest bindings of the last frame.
+    #
+    # The first call of a lazily bound function is counted twice, once for
+    # the stand-in that attaches it, and its time includes attaching.
+    #
+    # @example
+    #   FFI::Cpp::Profiler.enabled = true
+    #   # ...declare bindings, render a frame...
+    #   FFI::Cpp::Profiler.frame
+    #   FFI::Cpp::Profiler.report(:calls, 3).map(&:to_a)
+    #   # => [[:ofSetColor, 40000, 0.031], [:ofCircle, 40000, 0.118], ...]
+    module Profiler
+      # A binding's calls in one frame, and the seconds they took
+      Entry = ::Struct.new(:name, :calls, :seconds)
+
+      class << self
+        # @return [Boolean] wrap bindings declared from now on
+        attr_accessor :enabled
+      end
+
+      # @return [Float] seconds from a monotonic clock where there is one
+      def self.now
+        Process.clock_gettime Process::CLOCK_MONOTONIC
+      rescue NameError, ArgumentError
+        ::Time.now.to_f
+      end
+
+      # Forget everything counted so far, including the last frame
+      def self.reset
+        @calls, @seconds, @last, @ignoring = Hash.new(0), Hash.new(0.0), [], false
+      end
+      reset
+
+      # @api internal
+      def self.record name, seconds
+        return if @ignoring
+        @calls[name] += 1
+        @seconds[name] += seconds
+      end
+
+      # Close the frame, keeping its counts for {.report}, and start counting
+      # the next one
+      def self.frame
+        @last = @calls.map { |name, calls| Entry.new(name, calls, @seconds[name]) }
+        @calls, @seconds = Hash.new(0), Hash.new(0.0)
+      end
+
+      # @param by [Symbol] +:seconds+ or +:calls+
+      # @param limit [Fixnum] how many to list
+      #
+      # @return [Array<Entry>] the last frame's busiest bindings, busiest
+      #   first
+      def self.report by=:seconds, limit=10
+        @last.sort_by { |entry| -entry[by] }.first(limit)
+      end
+
+      # Run a block without counting the bindings it calls, e.g. to draw
+      # the report
+      def self.ignore
+        ignoring, @ignoring = @ignoring, true
+        yield
+      ensure
+        @ignoring = ignoring
+      end
+
+      # Count calls to +rbname+ in +mod+'s singleton
+      #
+      # @api internal
+      def self.wrap mod, rbname
+        name = rbname.to_sym
+        wrappers = mod.instance_variable_get(:@profiled) || mod.instance_variable_set(:@profiled, Module.new)
+        mod.singleton_class.send :prepend, wrappers unless mod.singleton_class.ancestors.include? wrappers
+
+        wrappers.send :define_method, name do |*args, &block|
+          start = Profiler.now
+          begin
+            super(*args, &block)
+          ensure
+            Profiler.record name, Profiler.now - start
+          end
+        end
+      end
+    end
+  end
+end
@@ -0,0 +1,97 @@
+require "set"
+
+module FFI::Cpp
+  # The symbols a shared object defines
+  #
+  # Lets {Library#attach_function} tell whether a function has C linkage or
+  # has to be mangled by looking it up, instead of trying the C name and
+  # rescuing the failure for nearly every binding. Symbols are listed with
+  # +nm+ the first time a library is seen, and saved beside it keyed by
+  # the library's path, size and modification time, so later runs just
+  # read them back without hashing the whole library.
+  class SymbolTable
+    class << self
+      # @return [SymbolTable] table for libraries attached to without
+      #   +ffi_lib+, i.e. the ones already loaded into the process
+      attr_accessor :default
+    end
+
+    @tables = {}
+
+    # @param path [String] path to a shared object
+    # @return [SymbolTable, nil] its symbols, or nil if they can't be listed
+    def self.for path
+      path = File.expand_path path.to_s
+      return nil unless File.file? path
+      @tables[path] ||= new(path).load
+    rescue SystemCallError
+      nil
+    end
+
+    def initialize path
+      @path = path
+      @cache = "#{path}.symbols"
+    end
+
+    # @return [SymbolTable, nil] self, or nil if the symbols couldn't be
+    #   listed
+    def load
+      key = stamp
+      names = read(key) || list
+      return nil unless names
+
+      save key, names
+      @symbols = Set.new names
+      self
+    end
+
+    def include? name
+      @symbols.include? name.to_s
+    end
+
+    def size
+      @symbols.size
+    end
+
+    private
+
+    # what the saved symbols are good for; a rebuilt library changes size
+    # or modification time
+    def stamp
+      stat = File.stat @path
+      "#{@path} #{stat.size} #{stat.mtime.to_i}.#{stat.mtime.nsec}"
+    end
+
+    def read key
+      return nil unless File.exist? @cache
+
+      lines = File.readlines(@cache).map(&:chomp)
+      lines.drop(1) if lines.first == key
+    end
+
+    # defined dynamic symbols, without the leading underscore Mach-O adds
+    def list
+      command = RUBY_PLATFORM =~ /darwin/ ? "nm -gU" : "nm -D --defined-only"
+      output = `#{command} "#{@path}" 2>/dev/null`
+      return nil unless $?.success?
+
+      names = output.lines.map { |line| line.split.last }.compact
+      names.map! { |name| name.sub(/\A_/, "") } if RUBY_PLATFORM =~ /darwin/
+      names
+    rescue SystemCallError
+      nil
+    end
+
+    # written aside and renamed into place, so a run starting alongside
+    # never reads half a cache
+    def save key, names
+      return if File.exist? @cache and File.open(@cache, &:gets).to_s.chomp == key
+      temp = "#{@cache}.#{Process.pid}"
+      File.open(temp, "w") { |f| f.puts key, names }
+      File.rename temp, @cache
+    rescue SystemCallError
+      # read-only install, list them again next time
+      File.unlink temp if temp and File.exist? temp rescue nil
+    end
+  end
+end
@@ -0,0 +1,146 @@
+#ifndef _FlightRecorder_h_header
+#define _FlightRecorder_h_header
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "FrameTime.h"
+
+// The last few thousand frames' timings, always recorded
+//
+// Ruby times each phase of the frame loop into the current frame (see
+// Zajal::Trace) and the frontend files it away at the end of the frame.
+// When a frame takes longer than the threshold, or when asked to with
+// requestFlightDump, which Ruby does on SIGUSR1, every recorded frame is
+// dumped as JSON to path-N.json, so a
+// stutter nobody can reproduce leaves a record of the frames leading up
+// to it. Only the last keep dumps are kept, N goes round from 0 to keep - 1,
+// so a sketch that stays slow for a week doesn't fill the disk.
+//
+// Frames that reloaded the sketch are slow by design, so they never count
+// as stutters. Dumps mark them "reload":true.
+
+#define FLIGHT_FRAMES 4096
+
+// frames between dumps for slow frames, so a run of them doesn't dump
+// every frame
+#define FLIGHT_COOLDOWN 600
+
+// phases, in the order of Zajal::Trace::Phases
+enum FlightPhase {
+  FLIGHT_SETUP, FLIGHT_FBO_BEGIN, FLIGHT_UPDATE, FLIGHT_DRAW, FLIGHT_FBO_END,
+  FLIGHT_BLIT, FLIGHT_SWAP_BUFFERS, FLIGHT_STALE_CHECK, FLIGHT_RELOAD, FLIGHT_GC,
+  FLIGHT_PHASES
+};
+
+static const char* flightPhaseNames[FLIGHT_PHASES] = {
+  "setup", "fbo_begin", "update", "draw", "fbo_end",
+  "blit", "swap_buffers", "stale_check", "reload", "gc"
+};
+
+// One frame. Ruby writes total, gc and phases by offset.
+struct FlightFrame {
+  double start;                // seconds since the sketch started
+  float total;                 // milliseconds the frame took
+  int gc;                      // garbage collections during it
+  int frame;
+  float phases[FLIGHT_PHASES]; // milliseconds in each phase
+};
+
+// Made with newFlightRecorder and freed with deleteFlightRecorder, the
+// frontends only hold a pointer to it
+struct FlightRecorder {
+  FlightFrame current;         // the frame being timed, first so Ruby finds it
+  FlightFrame* frames;         // FLIGHT_FRAMES of them, oldest overwritten
+  unsigned int recorded;
+  unsigned int lastDump;
+  int dumps;
+  int keep;                    // dumps kept on disk
+  float threshold;             // milliseconds, 0 to only dump when asked
+  char* path;                  // NULL until configured
+  bool dumpRequested;          // dump at the end of this frame
+};
+
+inline FlightRecorder* newFlightRecorder() {
+  FlightRecorder* recorder = new FlightRecorder;
+  memset(&recorder->current, 0, sizeof(FlightFrame));
+  recorder->frames = new FlightFrame[FLIGHT_FRAMES];
+  recorder->recorded = 0;
+  recorder->lastDump = 0;
+  recorder->dumps = 0;
+  recorder->keep = 1;
+  recorder->threshold = 0;
+  recorder->path = NULL;
+  recorder->dumpRequested = false;
+  return recorder;
+}
+
+inline void deleteFlightRecorder(FlightRecorder* recorder) {
+  if(!recorder) return;
+  delete[] recorder->frames;
+  free(recorder->path);
+  delete recorder;
+}
+
+// Start dumping to +path+-N.json, keeping +keep+ dumps. Nothing is dumped
+// before this.
+inline void configureFlightRecorder(FlightRecorder& recorder, const char* path, float threshold, int keep) {
+  free(recorder.path);
+  recorder.path = strdup(path);
+  recorder.threshold = threshold;
+  recorder.keep = keep > 0 ? keep : 1;
+}
+
+// Dump at the end of the current frame, whatever its time
+inline void requestFlightDump(FlightRecorder& recorder) {
+  recorder.dumpRequested = true;
+}
+
+inline void dumpFlightRecorder(FlightRecorder& recorder, const char* reason) {
+  size_t length = strlen(recorder.path) + 16;
+  char* file = (char*)malloc(length);
+  snprintf(file, length, "%s-%d.json", recorder.path, recorder.dumps++ % recorder.keep);
+  FILE* out = fopen(file, "w");
+  free(file);
+  if(!out) return;
+
+  unsigned int count = recorder.recorded < FLIGHT_FRAMES ? recorder.recorded : FLIGHT_FRAMES;
+  fprintf(out, "{\"reason\":\"%s\",\"threshold_ms\":%g,\"frames\":[\n", reason, recorder.threshold);
+  for(unsigned int i = recorder.recorded - count; i < recorder.recorded; i++) {
+    FlightFrame& f = recorder.frames[i % FLIGHT_FRAMES];
+    fprintf(out, "{\"frame\":%d,\"start\":%.6f,\"ms\":%.3f,\"gc\":%d,%s\"phases\":{", f.frame, f.start, f.total, f.gc,
+            f.phases[FLIGHT_RELOAD] > 0 ? "\"reload\":true," : "");
+    bool first = true;
+    for(int p = 0; p < FLIGHT_PHASES; p++) {
+      if(f.phases[p] == 0) continue;
+      fprintf(out, "%s\"%s\":%.3f", first ? "" : ",", flightPhaseNames[p], f.phases[p]);
+      first = false;
+    }
+    fprintf(out, "}}%s\n", i + 1 < recorder.recorded ? "," : "");
+  }
+  fprintf(out, "]}\n");
+  fclose(out);
+
+  recorder.lastDump = recorder.recorded;
+}
+
+// File the current frame away, dumping if it was slow or asked to
+inline void endFlightFrame(FlightRecorder& recorder, const FrameTime& time) {
+  FlightFrame& frame = recorder.frames[recorder.recorded++ % FLIGHT_FRAMES];
+  frame = recorder.current;
+  frame.start = time.start;
+  frame.frame = time.frame;
+  memset(&recorder.current, 0, sizeof(FlightFrame));
+
+  if(!recorder.path) return;
+
+  if(recorder.dumpRequested) {
+    recorder.dumpRequested = false;
+    dumpFlightRecorder(recorder, "requested");
+  } else if(recorder.threshold > 0 && frame.total > recorder.threshold && frame.phases[FLIGHT_RELOAD] == 0 &&
+            (recorder.dumps == 0 || recorder.recorded - recorder.lastDump >= FLIGHT_COOLDOWN)) {
+    dumpFlightRecorder(recorder, "slow frame");
+  }
+}
+
+#endif /* _FlightRecorder_h_header */
@@ -0,0 +1,25 @@
+#ifndef _FrameTime_h_header
+#define _FrameTime_h_header
+
+#include "ofUtils.h"
+
+// Timing of the current frame, shared by every frontend
+//
+// The frontend stamps it once as each frame begins, and the sketch reads it
+// straight out of memory, so asking for the time any number of times a
+// frame costs no clock calls. Everything asking during a frame sees the
+// same time. Ruby reads the fields by offset, see Zajal::Time.
+struct FrameTime {
+  double start; // seconds since the sketch started, as of this frame
+  double delta; // seconds since the previous frame started
+  int frame;    // frames drawn before this one
+};
+
+inline void beginFrameTime(FrameTime& time, int frame) {
+  double now = ofGetElapsedTimeMicros() / 1000000.0;
+  time.delta = frame > 0 ? now - time.start : 0.0;
+  time.start = now;
+  time.frame = frame;
+}
+
+#endif /* _FrameTime_h_header */
@@ -6,6 +6,35 @@ module Zajal
       # 
       # A sketch must be set before {#run} is called.
       attr_accessor :sketch
+
+      # Free the native frontend and its flight recorder. Call once it's
+      # done rendering, it can't be used after.
+      def close
+        Trace.flight = nil
+        Trace.dump_flight_on_signal
+        Zajal::Time.frame_time = nil
+        @pointer.free
+      end
+
+      # Close the frame for the profiler, if it's counting
+      def end_profile_frame
+        FFI::Cpp::Profiler.frame if FFI::Cpp::Profiler.enabled
+      end
+
+      # List the last frame's busiest bindings along the bottom of the
+      # screen, if the profiler is counting
+      # 
+      # @param height [Numeric] height of the screen
+      # @param limit [Fixnum] how many bindings to list
+      def draw_profile height, limit=10
+        return unless FFI::Cpp::Profiler.enabled
+
+        FFI::Cpp::Profiler.ignore do
+          entries = FFI::Cpp::Profiler.report :seconds, limit
+          lines = ["%-32s %8s %9s" % ["binding", "calls", "ms"]] + entries.map { |e| "%-32s %8d %9.3f" % [e.name, e.calls, e.seconds * 1000] }
+          lines.each_with_index { |line, i| @sketch.text line, 1.0, height - 10.0 * (lines.size - i) + 8.0 }
+        end
+      end
     end
   end
 end
\ No newline at end of file
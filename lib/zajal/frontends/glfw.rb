@@ -48,6 +48,10 @@ module Zajal
       def initialize width, height
         @pointer = Native.glfwfrontend_new
         Zajal::Graphics::Native.ofSetupOpenGL @pointer, width, height, 0 # TODO move this
+        Zajal::Time.frame_time = Native.glfwfrontend_getFrameTime @pointer
+        Native.glfwfrontend_configureFlightRecorder @pointer, Trace.flight_path, Trace::FlightThreshold, Trace::FlightKeep
+        Trace.flight = Native.glfwfrontend_getFlightFrame @pointer
+        Trace.dump_flight_on_signal { Native.glfwfrontend_requestFlightDump @pointer }
 
         @mousePositionCallback = Proc.new { |x, y| @sketch.mouse_moved x, y if @sketch }
         Native.glfwSetMousePosCallback @mousePositionCallback
@@ -58,11 +62,11 @@ module Zajal
         @keyButtonCallback = Proc.new { |button, action| action == Native::GLFW_RELEASE ? @sketch.key_up(button) : @sketch.key_down(button) if @sketch }
         Native.glfwSetKeyCallback @keyButtonCallback
 
-        @fbo = Zajal::Graphics::Fbo.new width, height, 0
+        @fbo = Resources.unkept { Zajal::Graphics::Fbo.new width, height, 0 }
       end
 
       def set_smoothing s
-        @fbo = Zajal::Graphics::Fbo.new @fbo.width, @fbo.height, s
+        @fbo = Resources.unkept { Zajal::Graphics::Fbo.new @fbo.width, @fbo.height, s }
       end
 
       # Run the sketch
@@ -77,29 +81,82 @@ module Zajal
       # @return [nil] Nothing
       def run
         @sketch.frontend = self # hack
-        @sketch.setup
-        @fbo.use { @sketch.draw } if @sketch.bare
+        Native.glfwfrontend_beginFrame @pointer
+        Trace.span(:setup) { @sketch.setup }
+        Trace.span(:draw) { @fbo.use { @sketch.draw } } if @sketch.bare
 
         while true do
-          @fbo.use { @sketch.update; @sketch.draw } unless @sketch.bare
-          @sketch.style do
-            @sketch.color :white
-            @fbo.draw 0, 0
-          end
+          Trace.frame do
+            Native.glfwfrontend_beginFrame @pointer
+            unless @sketch.bare
+              Trace.span(:fbo_begin) { @fbo.begin }
+              begin
+                Trace.span(:update) { @sketch.update }
+                Trace.span(:draw) { @sketch.draw }
+              ensure
+                Trace.span(:fbo_end) { @fbo.end }
+              end
+            end
 
-          Native.glfwSwapBuffers
-          Native.glfwfrontend_incrementFrameNum @pointer
+            Trace.span :blit do
+              @sketch.style do
+                @sketch.color :white
+                @fbo.draw 0, 0
+                draw_profile @fbo.height
+              end
+            end
 
-          # TODO this should be taken care of by Sketch
-          if @sketch.stale?
-            @sketch = @sketch.refresh_restart 
-            @sketch.frontend = self # hack
-            @sketch.setup
-            @fbo.use { @sketch.draw } if @sketch.bare
+            # GLFW polls for events as it swaps
+            Trace.span(:swap_buffers) { Native.glfwSwapBuffers }
+            if @reloaded
+              # the first frame of the new code is on screen
+              @sketch.watcher.record_latency if @sketch.watcher
+              @reloaded = false
+            end
+            FFI::Cpp::Std.reset_arena
+            FFI::Cpp::Owned.release_pending
+            end_profile_frame
+            Native.glfwfrontend_incrementFrameNum @pointer
 
-            Native.glfwfrontend_setFrameNum @pointer, 0
+            # TODO this should be taken care of by Sketch
+            # The file is read and checked on another thread, and the new
+            # sketch swapped in once it's ready. A newer save replaces one
+            # still being prepared.
+            @preparation = @sketch.prepare_refresh if Trace.span(:stale_check) { @sketch.stale? }
+
+            if @preparation and @preparation.ready?
+              preparation, @preparation = @preparation, nil
+              Trace.span :reload do
+                frame = Native.glfwfrontend_getFrameNum @pointer
+                begin
+                  sketch = @sketch.refresh_with preparation do |fresh|
+                    fresh.frontend = self # hack
+                    Native.glfwfrontend_setFrameNum @pointer, 0
+                    Native.glfwfrontend_beginFrame @pointer
+                    Trace.span(:setup) { fresh.setup }
+                    Trace.span(:draw) { @fbo.use { fresh.draw } } if fresh.bare
+                  end
+                rescue ScriptError, StandardError => e
+                  # keep the old sketch running until the file is fixed
+                  warn "#{@sketch.file.path}: #{e.class}: #{e.message}"
+                  Native.glfwfrontend_setFrameNum @pointer, frame
+                end
+
+                if sketch
+                  @sketch = sketch
+                  # setup has taken the old sketch's resources it wanted,
+                  # destroy the rest now, not eventually
+                  Resources.release_spares
+                  Trace.span(:gc) { GC.start }
+                  @reloaded = true
+                end
+              end
+            end
           end
+          Native.glfwfrontend_endFrame @pointer
         end
+      ensure
+        close
       end
 
       module Native
@@ -206,10 +263,18 @@ module Zajal
         attach_function :glfwSetWindowPos, [:int, :int], :void
 
         ffi_lib File.expand_path("glfw/lib/GlfwFrontend.so", File.dirname(__FILE__))
-        attach_constructor :GlfwFrontend, 16, []
+        attach_constructor :GlfwFrontend, 16, [] # pointers, see GLFW_FRONTEND_SIZE
+        attach_destructor :GlfwFrontend
         attach_method :GlfwFrontend, :setWindowShape, [:int, :int], :void
         attach_method :GlfwFrontend, :incrementFrameNum, [], :void
+        attach_method :GlfwFrontend, :getFrameNum, [], :int
         attach_method :GlfwFrontend, :setFrameNum, [:int], :void
+        attach_method :GlfwFrontend, :beginFrame, [], :void
+        attach_method :GlfwFrontend, :getFrameTime, [], :pointer
+        attach_method :GlfwFrontend, :endFrame, [], :void
+        attach_method :GlfwFrontend, :getFlightFrame, [], :pointer
+        attach_method :GlfwFrontend, :configureFlightRecorder, [:string, :float, :int], :void
+        attach_method :GlfwFrontend, :requestFlightDump, [], :void
       end
     end
   end
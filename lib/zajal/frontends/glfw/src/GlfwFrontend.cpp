@@ -1,8 +1,17 @@
 #include "GlfwFrontend.h"
 #include "GL/glfw.h"
 
+// Ruby only allocates GLFW_FRONTEND_SIZE bytes, fails to compile if the class outgrows them
+typedef char glfwFrontendFitsItsAllocation[sizeof(GlfwFrontend) <= GLFW_FRONTEND_SIZE ? 1 : -1];
+
 GlfwFrontend::GlfwFrontend() {
   frameCount = 0;
+  beginFrame();
+  flight = newFlightRecorder();
+}
+
+GlfwFrontend::~GlfwFrontend() {
+  deleteFlightRecorder(flight);
 }
 
 void GlfwFrontend::setupOpenGL(int w, int h, int screenMode) {
@@ -45,6 +54,30 @@ void GlfwFrontend::incrementFrameNum() {
   frameCount++;
 }
 
+void GlfwFrontend::beginFrame() {
+  beginFrameTime(frameTime, frameCount);
+}
+
+FrameTime* GlfwFrontend::getFrameTime() {
+  return &frameTime;
+}
+
+void GlfwFrontend::endFrame() {
+  endFlightFrame(*flight, frameTime);
+}
+
+FlightFrame* GlfwFrontend::getFlightFrame() {
+  return &flight->current;
+}
+
+void GlfwFrontend::configureFlightRecorder(const char* path, float threshold, int keep) {
+  ::configureFlightRecorder(*flight, path, threshold, keep);
+}
+
+void GlfwFrontend::requestFlightDump() {
+  ::requestFlightDump(*flight);
+}
+
 void GlfwFrontend::hideCursor() {
   glfwDisable(GLFW_MOUSE_CURSOR);
 }
@@ -2,9 +2,16 @@
 #define _GlfwFrontend_h_header
 
 #include "ofAppBaseWindow.h"
+#include "../../FrameTime.h"
+#include "../../FlightRecorder.h"
+
+// bytes Ruby allocates for a GlfwFrontend, the attach_constructor in
+// frontends/glfw.rb gives it in pointers
+#define GLFW_FRONTEND_SIZE (16 * sizeof(void*))
 
 class GlfwFrontend : public ofAppBaseWindow {
 	GlfwFrontend();
+	~GlfwFrontend();
 
 	void 	setupOpenGL(int w, int h, int screenMode);
 	int		getWidth();
@@ -21,7 +28,19 @@ class GlfwFrontend : public ofAppBaseWindow {
   void setFrameNum(int newFrameCount);
   void incrementFrameNum();
 
+  // stamp the frame that's starting, see FrameTime.h
+  void beginFrame();
+  FrameTime* getFrameTime();
+
+  // file the frame away in the flight recorder, see FlightRecorder.h
+  void endFrame();
+  FlightFrame* getFlightFrame();
+  void configureFlightRecorder(const char* path, float threshold, int keep);
+  void requestFlightDump();
+
   int frameCount;
+  FrameTime frameTime;
+  FlightRecorder* flight;
 };
 
 #endif /* _GlfwFrontend_h_header */
@@ -8,30 +8,63 @@ module Zajal
       
       attr_reader :fbo
 
+      # whether the draw hook flipping fbo images has been added
+      @@flipped = false
+
       def initialize w, h
         @pointer = Native.minimalfrontend_new
         Zajal::Graphics::Native.ofSetupOpenGL @pointer, w.to_i, h.to_i, 0 # TODO move this
+        Zajal::Time.frame_time = Native.minimalfrontend_getFrameTime @pointer
+        Native.minimalfrontend_configureFlightRecorder @pointer, Trace.flight_path, Trace::FlightThreshold, Trace::FlightKeep
+        Trace.flight = Native.minimalfrontend_getFlightFrame @pointer
+        Trace.dump_flight_on_signal { Native.minimalfrontend_requestFlightDump @pointer }
         
-        @fbo = Zajal::Graphics::Fbo.new w, h
+        @fbo = Resources.unkept { Zajal::Graphics::Fbo.new w, h }
       end
 
-      def run
-        # fbo images are flipped otherwise
-        @sketch.class.before_event :draw do
-          Zajal::Graphics::Native.ofSetupScreenPerspective width.to_f, height.to_f, :default, false, 60.0, 0.0, 0.0
+      # Render the sketch into {#fbo}
+      # 
+      # @param frames [Fixnum] how many frames to render, the sketch is set up
+      #   before the first
+      # @yield [frame] after each frame
+      def run frames=1
+        # fbo images are flipped otherwise. Hooks are shared by every sketch,
+        # so only add it once however many frontends and sketches run.
+        unless @@flipped
+          @sketch.class.before_event :draw do
+            Zajal::Graphics::Native.ofSetupScreenPerspective width.to_f, height.to_f, :default, false, 60.0, 0.0, 0.0
+          end
+          @@flipped = true
         end
 
-        @fbo.use do
-          @sketch.setup
-          @sketch.update
-          @sketch.draw
+        frames.times do |frame|
+          Trace.frame do
+            Native.minimalfrontend_beginFrame @pointer
+            Trace.span(:fbo_begin) { @fbo.begin }
+            Trace.span(:setup) { @sketch.setup } if frame == 0
+            Trace.span(:update) { @sketch.update }
+            Trace.span(:draw) { @sketch.draw }
+            Trace.span(:fbo_end) { @fbo.end }
+            FFI::Cpp::Std.reset_arena
+            FFI::Cpp::Owned.release_pending
+            end_profile_frame
+          end
+          Native.minimalfrontend_endFrame @pointer
+          yield frame if block_given?
         end
       end
 
       module Native
         extend FFI::Cpp::Library
         ffi_lib File.expand_path("minimal/lib/MinimalFrontend.so", File.dirname(__FILE__))
-        attach_constructor :MinimalFrontend, 16, []
+        attach_constructor :MinimalFrontend, 16, [] # pointers, see MINIMAL_FRONTEND_SIZE
+        attach_destructor :MinimalFrontend
+        attach_method :MinimalFrontend, :beginFrame, [], :void
+        attach_method :MinimalFrontend, :getFrameTime, [], :pointer
+        attach_method :MinimalFrontend, :endFrame, [], :void
+        attach_method :MinimalFrontend, :getFlightFrame, [], :pointer
+        attach_method :MinimalFrontend, :configureFlightRecorder, [:string, :float, :int], :void
+        attach_method :MinimalFrontend, :requestFlightDump, [], :void
       end
     end
   end
@@ -2,15 +2,37 @@
 #define _MinimalFrontend_h_header
 
 #include "ofAppBaseWindow.h"
+#include "../../FrameTime.h"
+#include "../../FlightRecorder.h"
+
+// bytes Ruby allocates for a MinimalFrontend, the attach_constructor in
+// frontends/headless.rb gives it in pointers
+#define MINIMAL_FRONTEND_SIZE (16 * sizeof(void*))
 
 class MinimalFrontend : public ofAppBaseWindow {
+public:
   MinimalFrontend();
+  ~MinimalFrontend();
 
   void  setupOpenGL(int w, int h, int screenMode);
   int width, height;
 
   int   getWidth();
   int   getHeight();
+
+  // stamp the frame that's starting, see FrameTime.h
+  void  beginFrame();
+  FrameTime* getFrameTime();
+
+  // file the frame away in the flight recorder, see FlightRecorder.h
+  void  endFrame();
+  FlightFrame* getFlightFrame();
+  void  configureFlightRecorder(const char* path, float threshold, int keep);
+  void  requestFlightDump();
+
+  int frameCount;
+  FrameTime frameTime;
+  FlightRecorder* flight;
   // ofPoint getWindowSize();
   // void  setWindowShape(int w, int h);
 };
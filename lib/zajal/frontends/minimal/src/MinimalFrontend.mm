@@ -4,7 +4,18 @@
 #import <Quartz/Quartz.h>
 #import <OpenGL/CGLMacro.h>
 
-MinimalFrontend::MinimalFrontend() {}
+// Ruby only allocates MINIMAL_FRONTEND_SIZE bytes, fails to compile if the class outgrows them
+typedef char minimalFrontendFitsItsAllocation[sizeof(MinimalFrontend) <= MINIMAL_FRONTEND_SIZE ? 1 : -1];
+
+MinimalFrontend::MinimalFrontend() {
+    frameCount = 0;
+    beginFrameTime(frameTime, 0);
+    flight = newFlightRecorder();
+}
+
+MinimalFrontend::~MinimalFrontend() {
+    deleteFlightRecorder(flight);
+}
 
 void MinimalFrontend::setupOpenGL(int w, int h, int screenMode) {
     // http://lists.apple.com/archives/mac-opengl/2010/Jun/msg00080.html
@@ -36,3 +47,26 @@ int MinimalFrontend::getHeight() {
     return height;
 }
 
+void MinimalFrontend::beginFrame() {
+    beginFrameTime(frameTime, frameCount++);
+}
+
+FrameTime* MinimalFrontend::getFrameTime() {
+    return &frameTime;
+}
+
+void MinimalFrontend::endFrame() {
+    endFlightFrame(*flight, frameTime);
+}
+
+FlightFrame* MinimalFrontend::getFlightFrame() {
+    return &flight->current;
+}
+
+void MinimalFrontend::configureFlightRecorder(const char* path, float threshold, int keep) {
+    ::configureFlightRecorder(*flight, path, threshold, keep);
+}
+
+void MinimalFrontend::requestFlightDump() {
+    ::requestFlightDump(*flight);
+}
@@ -0,0 +1,206 @@
+require "json"
+require "thread"
+require "fileutils"
+
+module Zajal
+  # A timeline of the frontends' frame loops, for chrome://tracing
+  #
+  # Set ZAJAL_TRACE to a file name and every phase of every frame is
+  # recorded, then written to that file as Chrome trace event JSON when
+  # Zajal exits. Open it in chrome://tracing or ui.perfetto.dev to see where
+  # a slow frame's time went. Phases that ran the garbage collector say how
+  # many times in their +gc+ argument, and frames say how long it took in
+  # +gc_ms+ where the Ruby can tell.
+  #
+  # Each thread records into its own buffer, so recording takes no locks.
+  # Recording stops once a thread has {Limit} events, and the trace says
+  # how many were dropped.
+  #
+  # Phases are also timed into the frontend's flight recorder whether
+  # tracing or not (see frontends/FlightRecorder.h). It keeps the last few
+  # thousand frames and dumps them to {FlightPath}-N.json when a frame
+  # takes longer than ZAJAL_FLIGHT_THRESHOLD milliseconds, or on SIGUSR1
+  # (see {.dump_flight_on_signal}).
+  # Frames that reload the sketch don't count, and only the last
+  # ZAJAL_FLIGHT_KEEP dumps are kept.
+  #
+  # @api internal
+  module Trace
+    # events kept per thread
+    Limit = (ENV["ZAJAL_TRACE_LIMIT"] || 1_000_000).to_i
+
+    # Phases the flight recorder keeps, in the order of FlightPhase
+    Phases = Hash[[:setup, :fbo_begin, :update, :draw, :fbo_end, :blit, :swap_buffers, :stale_check, :reload, :gc].each_with_index.to_a]
+
+    # Where the flight recorder dumps, and how slow a frame has to be in
+    # milliseconds, 0 to only dump on SIGUSR1
+    FlightPath = ENV["ZAJAL_FLIGHT_RECORDER"] || File.expand_path("~/.zajal/flight/#{::Time.now.strftime '%Y%m%d-%H%M%S'}-#{Process.pid}")
+    FlightThreshold = (ENV["ZAJAL_FLIGHT_THRESHOLD"] || 100).to_f
+
+    # How many dumps are kept, older ones are overwritten
+    FlightKeep = (ENV["ZAJAL_FLIGHT_KEEP"] || 10).to_i
+
+    # offsets into FlightFrame
+    FlightTotal, FlightGc, FlightPhases = 8, 12, 20
+
+    # One thread's events, flattened four values to an event
+    class Buffer
+      attr_reader :thread, :values
+      attr_accessor :dropped
+
+      def initialize thread
+        @thread, @values, @dropped = thread, [], 0
+      end
+
+      def record name, start, finish, args
+        if @values.size < Limit * 4
+          @values.push name, start, finish, args
+        else
+          @dropped += 1
+        end
+      end
+    end
+
+    @buffers = []
+    @registering = Mutex.new
+
+    class << self
+      # @return [String, nil] where the trace is written, nil if not tracing
+      attr_reader :path
+
+      # @return [FFI::Pointer, nil] the frontend's current FlightFrame,
+      #   phases are timed into it
+      attr_accessor :flight
+    end
+
+    # Call the block on SIGUSR1 to have the frontend's flight recorder
+    # dump, or stop without a block. A Ruby handler the signal had before
+    # still runs after it, so a sketch's own trap keeps working.
+    def self.dump_flight_on_signal &request
+      @flight_dump = request
+      return if @trapped
+
+      previous = Signal.trap "USR1" do |signal|
+        @flight_dump.call if @flight_dump
+        previous.call signal if previous.respond_to? :call
+      end
+      @trapped = true
+    end
+
+    # @return [String] {FlightPath}, with its directory made
+    def self.flight_path
+      FileUtils.mkdir_p File.dirname(FlightPath)
+      FlightPath
+    end
+
+    # Start tracing, and write the trace to +path+ on exit
+    def self.enable path
+      @path = path
+      GC::Profiler.enable if defined? GC::Profiler
+      at_exit { write }
+    end
+
+    # @return [Float] microseconds from a monotonic clock where there is one
+    def self.now
+      Process.clock_gettime(Process::CLOCK_MONOTONIC) * 1e6
+    rescue NameError, ArgumentError
+      ::Time.now.to_f * 1e6
+    end
+
+    def self.gc_count
+      GC.respond_to?(:count) ? GC.count : 0
+    end
+
+    # @return [Buffer] the calling thread's buffer
+    def self.buffer
+      Thread.current[:zajal_trace] ||= @registering.synchronize do
+        Buffer.new(Thread.current).tap { |buffer| @buffers << buffer }
+      end
+    end
+
+    # Record the block as phase +name+
+    def self.span name
+      return yield unless @path or @flight
+
+      start, collections = now, gc_count
+      begin
+        yield
+      ensure
+        finish = now
+        if @flight and phase = Phases[name]
+          offset = FlightPhases + phase * 4
+          @flight.put_float32 offset, @flight.get_float32(offset) + (finish - start) / 1000.0
+        end
+        if @path
+          collections = gc_count - collections
+          buffer.record name, start, finish, collections.zero? ? nil : { gc: collections }
+        end
+      end
+    end
+
+    # Record the block as a frame, with the time the garbage collector took
+    # during it. The frontend files it in its flight recorder after.
+    def self.frame
+      return yield unless @path or @flight
+
+      start, collections = now, gc_count
+      begin
+        yield
+      ensure
+        finish = now
+        if @flight
+          @flight.put_float32 FlightTotal, (finish - start) / 1000.0
+          @flight.put_int32 FlightGc, gc_count - collections
+        end
+        if @path
+          gc_ms = nil
+          if defined? GC::Profiler and GC::Profiler.enabled?
+            gc_ms = GC::Profiler.total_time * 1000
+            GC::Profiler.clear
+          end
+          buffer.record :frame, start, finish, gc_ms && { gc_ms: gc_ms }
+        end
+      end
+    end
+
+    # Record a span +name+ that ends now and lasted +seconds+, for things
+    # measured elsewhere
+    def self.latency name, seconds
+      return unless @path
+
+      finish = now
+      buffer.record name, finish - seconds * 1e6, finish, nil
+    end
+
+    # Write everything recorded so far as Chrome trace event JSON
+    def self.write path=@path
+      pid = Process.pid
+
+      File.open(path, "w") do |file|
+        file.puts '{"displayTimeUnit":"ms","traceEvents":['
+        first = true
+        emit = lambda do |event|
+          file.puts "," unless first
+          file.write JSON.generate(event)
+          first = false
+        end
+
+        @buffers.each_with_index do |buffer, tid|
+          name = buffer.thread == Thread.main ? "main" : "thread #{tid}"
+          emit.call ph: "M", name: "thread_name", pid: pid, tid: tid, args: { name: name }
+          emit.call ph: "i", s: "t", name: "dropped #{buffer.dropped} events", pid: pid, tid: tid, ts: buffer.values[-2].round(3) unless buffer.dropped.zero?
+
+          buffer.values.each_slice(4) do |phase, start, finish, args|
+            event = { ph: "X", cat: "zajal", name: phase, pid: pid, tid: tid, ts: start.round(3), dur: (finish - start).round(3) }
+            event[:args] = args if args
+            emit.call event
+          end
+        end
+
+        file.puts "\n]}"
+      end
+    end
+  end
+end
+
+Zajal::Trace.enable ENV["ZAJAL_TRACE"] if ENV["ZAJAL_TRACE"]
@@ -0,0 +1,33 @@
+require_relative '../spec_helper'
+require_relative '../../lib/zajal/core/cache'
+require 'tmpdir'
+
+describe Zajal::Cache do
+  around do |example|
+    Dir.mktmpdir do |dir|
+      ENV["ZAJAL_CACHE"] = dir
+      example.run
+      ENV.delete "ZAJAL_CACHE"
+    end
+  end
+
+  describe ".path" do
+    it "lives under the cache root" do
+      Zajal::Cache.path("atlas", "abc", "layout").should == File.join(ENV["ZAJAL_CACHE"], "atlas", "abc", "layout")
+    end
+
+    it "creates parent directories" do
+      File.directory?(File.dirname(Zajal::Cache.path("atlas", "abc", "layout"))).should == true
+    end
+  end
+
+  describe ".key" do
+    it "is stable for the same parts" do
+      Zajal::Cache.key(1024, "a").should == Zajal::Cache.key(1024, "a")
+    end
+
+    it "does not collide when parts are split differently" do
+      Zajal::Cache.key("ab", "c").should_not == Zajal::Cache.key("a", "bc")
+    end
+  end
+end
@@ -0,0 +1,55 @@
+require_relative '../spec_helper'
+require_relative '../../lib/zajal/core/resources'
+
+describe Zajal::Resources do
+  before do
+    Zajal::Resources.reload {}
+    Zajal::Resources.release_spares
+  end
+
+  def fetch *key
+    Zajal::Resources.fetch(*key) { Object.new }
+  end
+
+  it "makes a new resource each time outside a reload" do
+    fetch(:fbo, 10, 10).should_not equal fetch(:fbo, 10, 10)
+  end
+
+  it "hands the old sketch's resources to the new one" do
+    old = fetch :fbo, 10, 10
+    Zajal::Resources.reload { fetch :fbo, 10, 10 }.should equal old
+  end
+
+  it "only hands over resources made from the same key" do
+    old = fetch :fbo, 10, 10
+    Zajal::Resources.reload { fetch :fbo, 20, 10 }.should_not equal old
+  end
+
+  it "keeps spares until they are released" do
+    old = fetch :fbo, 10, 10
+    Zajal::Resources.reload {}
+    fetch(:fbo, 10, 10).should equal old
+
+    other = fetch :font, "a.ttf", 12
+    Zajal::Resources.reload {}
+    Zajal::Resources.release_spares
+    fetch(:font, "a.ttf", 12).should_not equal other
+  end
+
+  it "never hands over forgotten resources" do
+    old = fetch :image, "a.png"
+    Zajal::Resources.forget [:image, "a.png"], old
+    Zajal::Resources.reload { fetch :image, "a.png" }.should_not equal old
+  end
+
+  it "gives the old sketch its resources back if the new one fails to load" do
+    old = fetch :fbo, 10, 10
+    lambda { Zajal::Resources.reload { fetch :fbo, 10, 10; raise SyntaxError } }.should raise_error(SyntaxError)
+    Zajal::Resources.reload { fetch :fbo, 10, 10 }.should equal old
+  end
+
+  it "makes resources without keeping them when asked" do
+    old = Zajal::Resources.unkept { fetch :fbo, 10, 10 }
+    Zajal::Resources.reload { fetch :fbo, 10, 10 }.should_not equal old
+  end
+end
@@ -0,0 +1,86 @@
+require_relative '../spec_helper'
+require 'ffi'
+require_relative '../../lib/zajal/ffipp/ffipp'
+require_relative '../../lib/zajal/ffipp/symbols'
+require_relative '../../lib/zajal/ffipp/profiler'
+
+describe FFI::Cpp::Library do
+  describe "#bind_lazily" do
+    let(:native) do
+      Module.new do
+        extend FFI::Cpp::Library
+        ffi_lib FFI::Library::LIBC
+        bind_lazily
+
+        attach_function :strlen, [:string], :size_t
+        attach_function :zajal_no_such_function, [], :void
+      end
+    end
+
+    it "attaches a function the first time it's called" do
+      native.instance_variable_get(:@deferred).keys.should include(:strlen)
+      native.strlen("zajal").should == 5
+      native.instance_variable_get(:@deferred).keys.should_not include(:strlen)
+      native.strlen("live coding").should == 11
+    end
+
+    it "passes calls through stand-ins captured with #method" do
+      strlen = native.method :strlen
+      native.strlen("zajal").should == 5
+      strlen.call("sketch").should == 6
+    end
+
+    it "raises for a missing symbol on every call" do
+      lambda { native.zajal_no_such_function }.should raise_error(FFI::NotFoundError)
+      lambda { native.zajal_no_such_function }.should raise_error(FFI::NotFoundError)
+    end
+
+    it "raises for a missing symbol through a stand-in captured with #method" do
+      missing = native.method :zajal_no_such_function
+      lambda { missing.call }.should raise_error(FFI::NotFoundError)
+      lambda { missing.call }.should raise_error(FFI::NotFoundError)
+    end
+
+    it "still attaches the other functions after a missing symbol" do
+      lambda { native.zajal_no_such_function }.should raise_error(FFI::NotFoundError)
+      native.strlen("zajal").should == 5
+    end
+  end
+
+  describe "with a deferred library" do
+    it "opens it when a function can't be attached without it" do
+      FFI::Cpp.defer_library "libbz2.so.1"
+      native = Module.new do
+        extend FFI::Cpp::Library
+        attach_function :BZ2_bzlibVersion, [], :string
+      end
+
+      native.BZ2_bzlibVersion.should =~ /\A1\./
+      FFI::Cpp.open_deferred_libraries.should == false
+    end
+  end
+
+  describe "#bind" do
+    let(:native) { Module.new { extend FFI::Cpp::Library } }
+
+    it "attaches right away unless binding lazily" do
+      attached = false
+      native.bind(:widget) { attached = true }
+      attached.should == true
+    end
+
+    it "defers attaching when binding lazily" do
+      attached = 0
+      native.bind_lazily
+      native.bind(:widget) do
+        attached += 1
+        native.singleton_class.send(:define_method, :widget) { :attached }
+      end
+
+      attached.should == 0
+      native.widget.should == :attached
+      native.widget.should == :attached
+      attached.should == 1
+    end
+  end
+end
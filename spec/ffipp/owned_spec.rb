@@ -0,0 +1,79 @@
+require_relative '../spec_helper'
+require 'ffi'
+require_relative '../../lib/zajal/ffipp/ffipp'
+
+describe FFI::Cpp::Owned do
+  let(:destroyed) { [] }
+  let(:destructor) { lambda { |memory| destroyed << memory } }
+
+  def owned
+    FFI::Cpp::Owned.new FFI::Cpp::Owned.malloc(1), :Widget, destructor
+  end
+
+  before { FFI::Cpp::Owned.release_pending }
+
+  it "counts live objects by class" do
+    before = FFI::Cpp::Owned.live[:Widget] || 0
+    widgets = [owned, owned]
+    FFI::Cpp::Owned.live[:Widget].should == before + 2
+    widgets.each(&:free)
+  end
+
+  it "destroys right away when freed" do
+    widget = owned
+    before = FFI::Cpp::Owned.live[:Widget]
+    widget.free
+    destroyed.size.should == 1
+    (FFI::Cpp::Owned.live[:Widget] || 0).should == before - 1
+  end
+
+  it "frees its memory after destroying" do
+    memory = FFI::Cpp::Owned.malloc 1
+    widget = FFI::Cpp::Owned.new memory, :Widget, destructor
+    FFI::Cpp::Owned::Heap.should_receive(:free).and_return(nil)
+    widget.free
+    destroyed.should == [memory]
+  end
+
+  it "leaves collected objects for release_pending" do
+    memory = FFI::Cpp::Owned.malloc 1
+    FFI::Cpp::Owned.count :Widget, 1
+    Thread.new { FFI::Cpp::Owned.releaser(memory, :Widget, destructor).call(memory) }.join
+
+    destroyed.should == []
+    FFI::Cpp::Owned.release_pending
+    destroyed.should == [memory]
+  end
+
+  describe "from a class with a destructor attached" do
+    let(:native) do
+      Module.new do
+        extend FFI::Cpp::Library
+        bind_lazily
+
+        attach_constructor :Widget, 2, [:int]
+        attach_destructor :Widget
+      end
+    end
+
+    before do
+      destroyed = self.destroyed
+      native.define_singleton_method(:widget_ctor) { |memory, size| memory.put_int32 0, size }
+      native.define_singleton_method(:widget_dtor) { |memory| destroyed << memory.get_int32(0) }
+    end
+
+    it "is constructed by _new" do
+      widget = native.widget_new 7
+      widget.should be_kind_of FFI::Cpp::Owned
+      widget.get_int32(0).should == 7
+      widget.free
+      destroyed.should == [7]
+    end
+
+    it "frees its memory if the constructor raises" do
+      native.define_singleton_method(:widget_ctor) { |memory, size| raise FFI::NotFoundError, "no Widget" }
+      FFI::Cpp::Owned::Heap.should_receive(:free).and_return(nil)
+      lambda { native.widget_new 7 }.should raise_error(FFI::NotFoundError)
+    end
+  end
+end
@@ -0,0 +1,59 @@
+require_relative '../spec_helper'
+require_relative '../../lib/zajal/ffipp/profiler'
+
+describe FFI::Cpp::Profiler do
+  let(:native) do
+    Module.new do
+      def self.circle x, y, r; [x, y, r] end
+      def self.color c; c end
+    end
+  end
+
+  before do
+    FFI::Cpp::Profiler.reset
+    FFI::Cpp::Profiler.wrap native, :circle
+    FFI::Cpp::Profiler.wrap native, :color
+  end
+
+  it "passes calls through" do
+    native.circle(1, 2, 3).should == [1, 2, 3]
+  end
+
+  it "counts calls per frame" do
+    3.times { native.circle 1, 2, 3 }
+    native.color :red
+    FFI::Cpp::Profiler.frame
+
+    FFI::Cpp::Profiler.report(:calls).map { |e| [e.name, e.calls] }.should == [[:circle, 3], [:color, 1]]
+  end
+
+  it "starts each frame from zero" do
+    native.circle 1, 2, 3
+    FFI::Cpp::Profiler.frame
+    FFI::Cpp::Profiler.frame
+
+    FFI::Cpp::Profiler.report.should == []
+  end
+
+  it "times calls" do
+    native.circle 1, 2, 3
+    FFI::Cpp::Profiler.frame
+
+    FFI::Cpp::Profiler.report.first.seconds.should >= 0.0
+  end
+
+  it "limits the report" do
+    native.circle 1, 2, 3
+    native.color :red
+    FFI::Cpp::Profiler.frame
+
+    FFI::Cpp::Profiler.report(:calls, 1).size.should == 1
+  end
+
+  it "doesn't count ignored calls" do
+    FFI::Cpp::Profiler.ignore { native.circle 1, 2, 3 }
+    FFI::Cpp::Profiler.frame
+
+    FFI::Cpp::Profiler.report.should == []
+  end
+end
@@ -0,0 +1,71 @@
+require_relative '../spec_helper'
+require 'ffi'
+require_relative '../../lib/zajal/ffipp/ffipp'
+require_relative '../../lib/zajal/ffipp/symbols'
+require_relative '../../lib/zajal/ffipp/profiler'
+
+# std::string's symbols have to be in the process before Std attaches them.
+# Without a compiler's dev files there's only the versioned library.
+begin
+  FFI::Cpp.open_library FFI.map_library_name("stdc++")
+rescue LoadError
+  FFI::Cpp.open_library "libstdc++.so.6"
+end
+require_relative '../../lib/zajal/ffipp/libstdcpp'
+
+describe FFI::Cpp::Std do
+  let(:std) { FFI::Cpp::Std }
+
+  before do
+    std.instance_variable_set :@interned, {}
+    std.instance_variable_set :@arena, []
+    std.reset_arena
+    std.stub(:string_new) { Object.new }
+    std.stub(:string_assign)
+  end
+
+  describe ".intern" do
+    it "reuses the std::string for equal frozen strings" do
+      std.intern("zajal".freeze).should equal std.intern("zajal".freeze)
+    end
+
+    it "goes through the arena past InternLimit strings" do
+      FFI::Cpp::Std::InternLimit.times { |i| std.intern(i.to_s.freeze) }
+      late = std.intern("late".freeze)
+      std.intern("late".freeze).should_not equal late
+    end
+  end
+
+  describe ".transient" do
+    it "hands out a different string each call within a frame" do
+      std.transient("a").should_not equal std.transient("b")
+    end
+
+    it "hands the same strings out again after reset_arena" do
+      first = std.transient "a"
+      std.reset_arena
+      std.transient("b").should equal first
+    end
+
+    it "never hands out a string twice in a frame" do
+      strings = 300.times.map { |i| std.transient i.to_s }
+      strings.uniq(&:object_id).size.should == 300
+    end
+
+    it "raises rather than reuse a string past ArenaLimit" do
+      FFI::Cpp::Std::ArenaLimit.times { std.transient "a" }
+      lambda { std.transient "b" }.should raise_error(IndexError)
+    end
+  end
+
+  describe "String" do
+    it "copies frozen strings too for parameters the callee may change" do
+      "zajal".freeze.to_ptr.should_not equal "zajal".freeze.to_ptr
+    end
+
+    it "interns frozen strings for const references" do
+      "zajal".freeze.to_const_ref.should equal "zajal".freeze.to_const_ref
+      "zajal".dup.to_const_ref.should_not equal "zajal".dup.to_const_ref
+    end
+  end
+end
@@ -0,0 +1,76 @@
+require_relative '../spec_helper'
+require 'ffi'
+require 'tmpdir'
+require_relative '../../lib/zajal/ffipp/ffipp'
+require_relative '../../lib/zajal/ffipp/symbols'
+
+describe FFI::Cpp::SymbolTable do
+  around do |example|
+    Dir.mktmpdir do |dir|
+      @library = File.join(dir, "libwidget.so")
+      File.open(@library, "w") { |f| f.write "version 1" }
+      example.run
+    end
+  end
+
+  def table
+    FFI::Cpp::SymbolTable.new @library
+  end
+
+  it "lists symbols and saves them beside the library" do
+    listed = table
+    listed.stub(:list).and_return(["widget_new", "_ZN6Widget4drawEv"])
+    listed.load.should equal listed
+
+    listed.include?("widget_new").should == true
+    listed.include?("widget_free").should == false
+    File.exist?("#{@library}.symbols").should == true
+  end
+
+  it "reads saved symbols back without listing them" do
+    listed = table
+    listed.stub(:list).and_return(["widget_new"])
+    listed.load
+
+    read = table
+    read.should_not_receive(:list)
+    read.load.include?("widget_new").should == true
+  end
+
+  it "lists symbols again when the library changes" do
+    listed = table
+    listed.stub(:list).and_return(["widget_new"])
+    listed.load
+
+    File.open(@library, "w") { |f| f.write "version 2, rebuilt" }
+    relisted = table
+    relisted.should_receive(:list).and_return(["widget_make"])
+    relisted.load.include?("widget_make").should == true
+    table.load.include?("widget_new").should == false
+  end
+
+  it "lists symbols again when the library is touched" do
+    listed = table
+    listed.stub(:list).and_return(["widget_new"])
+    listed.load
+
+    File.utime Time.now, File.mtime(@library) + 60, @library
+    relisted = table
+    relisted.should_receive(:list).and_return(["widget_make"])
+    relisted.load.include?("widget_make").should == true
+  end
+
+  it "leaves only the cache behind after saving" do
+    listed = table
+    listed.stub(:list).and_return(["widget_new"])
+    listed.load
+
+    Dir.children(File.dirname(@library)).sort.should == ["libwidget.so", "libwidget.so.symbols"]
+  end
+
+  it "gives up on libraries it can't list" do
+    unlisted = table
+    unlisted.stub(:list).and_return(nil)
+    unlisted.load.should be_nil
+  end
+end
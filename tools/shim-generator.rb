@@ -0,0 +1,41 @@
+# C++ source for libzajalshim.so, from the entries in lib/zajal/core/shim/spec.rb
+def shim_source entries
+  types = { float: "float", int: "int", double: "double", bool: "bool", void: "void" }
+
+  functions = entries.values.map do |entry|
+    if entry.batched?
+      stride = entry.params.size
+      locals = entry.params.each_with_index.map { |(name, type), i| "    #{types.fetch type} #{name} = (#{types.fetch type})data[#{i}];" }
+      body = entry.body.lines.map { |line| "    #{line.chomp}" }
+
+      <<-cpp
+void #{entry.symbol}(const float* data, int count) {
+  for(int i = 0; i < count; i++, data += #{stride}) {
+#{locals.join("\n")}
+#{body.join("\n")}
+  }
+}
+      cpp
+    else
+      params = entry.params.map { |name, type| "#{types.fetch type} #{name}" }
+      body = entry.body.lines.map { |line| "  #{line.chomp}" }
+
+      <<-cpp
+#{types.fetch entry.returns} #{entry.symbol}(#{params.join(', ')}) {
+#{body.join("\n")}
+}
+      cpp
+    end
+  end
+
+  <<-cpp
+// Generated from lib/zajal/core/shim/spec.rb by `rake shim`, don't edit
+
+#include "ofMain.h"
+
+extern "C" {
+
+#{functions.join("\n")}
+}
+  cpp
+end